@@ -0,0 +1,102 @@
+#include "../NameIndex.h"
+#include "../Rng.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Insert / lookup throughput of NameIndex against the unordered_map it
+ * replaced, at 10^6 .. 10^7 processes.
+ *
+ *   NameIndexBench [max-processes]     (default 10000000)
+ *
+ * "generated" names are Process_<pid> as made by scheduler-start and take
+ * the parse fast path; "custom" names go through the hash table. The worst
+ * single insert shows whether growing the table stalls the caller.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+    double insert_mops;
+    double lookup_mops;
+    double worst_insert_us;
+    long   misses;
+};
+
+static double seconds(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count();
+}
+
+template <typename Insert, typename Lookup>
+static Result run(int n, const std::vector<std::string>& names, const std::vector<int>& probes, Insert insert, Lookup lookup) {
+    Result r = {};
+    double worst = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; i++) {
+        Clock::time_point t0 = Clock::now();
+        insert(names[i], i);
+        double took = seconds(t0, Clock::now());
+        if (took > worst) worst = took;
+    }
+    r.insert_mops = n / seconds(start, Clock::now()) / 1e6;
+    r.worst_insert_us = worst * 1e6;
+
+    start = Clock::now();
+    for (int p : probes) {
+        if (lookup(names[p]) != p) r.misses++;
+    }
+    r.lookup_mops = probes.size() / seconds(start, Clock::now()) / 1e6;
+    return r;
+}
+
+static void report(const char* what, int n, const Result& r) {
+    printf("%-28s %10d %12.2f %12.2f %14.1f %8ld\n", what, n, r.insert_mops, r.lookup_mops, r.worst_insert_us, r.misses);
+}
+
+int main(int argc, char* argv[]) {
+    int max_n = argc > 1 ? atoi(argv[1]) : 10000000;
+    const int lookups = 2000000;
+
+    printf("%-28s %10s %12s %12s %14s %8s\n", "index / names", "processes", "insert Mop/s", "lookup Mop/s", "worst insert us", "misses");
+
+    for (int n = 1000000; n <= max_n; n *= 10) {
+        Rng rng(n);
+        std::vector<int> probes(lookups);
+        for (int& p : probes) p = (int)rng.range(0, n - 1);
+
+        std::vector<std::string> generated(n), custom(n);
+        for (int i = 0; i < n; i++) {
+            generated[i] = generatedName(i);
+            custom[i] = "job-" + std::to_string(rng.next()) + "-" + std::to_string(i);
+        }
+
+        for (int pass = 0; pass < 2; pass++) {
+            const std::vector<std::string>& names = pass == 0 ? generated : custom;
+            const char* label = pass == 0 ? "generated" : "custom";
+            char what[64];
+
+            {
+                NameIndex index;
+                Result r = run(n, names, probes,
+                    [&](const std::string& s, int pid) { index.add(s, pid); },
+                    [&](const std::string& s) { return index.find(s); });
+                snprintf(what, sizeof(what), "NameIndex / %s", label);
+                report(what, n, r);
+            }
+            {
+                std::unordered_map<std::string, int> map;
+                Result r = run(n, names, probes,
+                    [&](const std::string& s, int pid) { map[s] = pid; },
+                    [&](const std::string& s) { auto it = map.find(s); return it == map.end() ? -1 : it->second; });
+                snprintf(what, sizeof(what), "unordered_map / %s", label);
+                report(what, n, r);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include "../Scheduler.h"
+#include "../Rng.h"
+#include <Windows.h>
+#include <Psapi.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "psapi.lib")
+
+/*
+ * ScreenManager scaling sweep: core count x quantum x process count x
+ * instruction-count distribution, for both fcfs and rr.
+ *
+ *   SchedulerBench [--quick] [--realtime] [--duration ms] [--cores 1,2,4] [--quantum 1,5]
+ *                  [--processes 100,1000] [--out results.csv]
+ *
+ * By default the clock runs in lockstep: it ticks as soon as every core is
+ * waiting on a later tick, so throughput is bounded by what ScreenManager
+ * costs on the host rather than by the 1 ms tick. --realtime keeps the
+ * emulator's 1 ms clock, where instr_per_sec is mostly cores x ticks/s.
+ *
+ * Every configuration runs in a child process (SchedulerBench --run ...)
+ * so peak RSS is per configuration and core threads never outlive the
+ * ScreenManager that owns them. A run stops after <duration> ms of host
+ * time or once every process has finished, whichever comes first.
+ *
+ * Columns:
+ *   instr_per_sec      instructions executed per host second
+ *   efficiency         instructions / (cores * (ticks + 1)); a core runs at most
+ *                      one instruction per tick, ticks 0..cycles, so 1.0 = never idle
+ *   cpu_us_per_instr   host CPU time (user + kernel, all threads) per instruction
+ *   mean/max_wait      ticks a process sat in a ready queue before dispatch
+ *   contention_pct     lock acquisitions that found the lock already held
+ *   peak_rss_kb        peak working set of the child
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+struct Distribution {
+    const char* name;
+    int short_pct;              // share of processes drawn from the short range
+    int short_min, short_max;
+    int long_min, long_max;
+};
+
+static const Distribution DISTRIBUTIONS[] = {
+    { "short", 100,  50,  100,    0,    0 },
+    { "long",    0,   0,    0, 1000, 2000 },
+    { "mixed",  90,  50,  100, 2000, 5000 },
+};
+
+static const char CSV_HEADER[] =
+    "mode,cores,quantum,processes,distribution,elapsed_ms,cycles,instructions,instr_per_sec,efficiency,"
+    "finished,dispatches,mean_wait,max_wait,migrations,lock_acquisitions,lock_contended,contention_pct,peak_rss_kb,"
+    "clock,cpu_ms,cpu_us_per_instr";
+
+struct Row {
+    std::string mode;
+    int cores = 0;
+    int quantum = 0;
+    int processes = 0;
+    std::string distribution;
+    double elapsed_ms = 0;
+    SchedulerStats st = {};
+    double instr_per_sec = 0;
+    double efficiency = 0;
+    double mean_wait = 0;
+    double contention_pct = 0;
+    uint64_t peak_rss_kb = 0;
+    std::string clock;
+    double cpu_ms = 0;
+    double cpu_us_per_instr = 0;
+};
+
+static std::string toCsv(const Row& r) {
+    char line[512];
+    snprintf(line, sizeof(line), "%s,%d,%d,%d,%s,%.0f,%llu,%llu,%.0f,%.3f,%llu,%llu,%.2f,%llu,%llu,%llu,%llu,%.3f,%llu,%s,%.0f,%.3f",
+        r.mode.c_str(), r.cores, r.quantum, r.processes, r.distribution.c_str(), r.elapsed_ms,
+        (unsigned long long)r.st.cycles, (unsigned long long)r.st.instructions, r.instr_per_sec, r.efficiency,
+        (unsigned long long)r.st.finished, (unsigned long long)r.st.dispatches, r.mean_wait,
+        (unsigned long long)r.st.dispatch_wait_max, (unsigned long long)r.st.migrations,
+        (unsigned long long)r.st.lock_acquisitions, (unsigned long long)r.st.lock_contended,
+        r.contention_pct, (unsigned long long)r.peak_rss_kb, r.clock.c_str(), r.cpu_ms, r.cpu_us_per_instr);
+    return line;
+}
+
+/* only the fields the summary needs */
+static bool fromCsv(const std::string& line, Row& r) {
+    std::vector<std::string> f;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) f.push_back(field);
+    if (f.size() != 22) return false;
+
+    r.mode = f[0];
+    r.cores = atoi(f[1].c_str());
+    r.instr_per_sec = atof(f[8].c_str());
+    r.efficiency = atof(f[9].c_str());
+    r.mean_wait = atof(f[12].c_str());
+    r.st.migrations = strtoull(f[14].c_str(), nullptr, 10);
+    r.contention_pct = atof(f[17].c_str());
+    r.peak_rss_kb = strtoull(f[18].c_str(), nullptr, 10);
+    r.cpu_us_per_instr = atof(f[21].c_str());
+    return true;
+}
+
+static uint64_t peakRssKb() {
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (uint64_t)(pmc.PeakWorkingSetSize / 1024);
+}
+
+/* user + kernel time of every thread in this process */
+static double hostCpuMs() {
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) { return ((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 10000.0;     // 100 ns units
+}
+
+static const Distribution* findDistribution(const std::string& name) {
+    for (const Distribution& d : DISTRIBUTIONS) {
+        if (name == d.name) return &d;
+    }
+    return nullptr;
+}
+
+/* child side: one configuration, one CSV row on stdout */
+static int runOne(const std::string& mode, int cores, int quantum, int processes, const Distribution& dist, int duration_ms, bool lockstep) {
+    const uint64_t seed = 1;
+    Rng rng(seed);
+
+    Clock::time_point start = Clock::now();
+    double cpu_start = hostCpuMs();
+    ScreenManager manager(cores, 0, quantum, mode == "rr" ? 1 : 0, seed);
+    manager.setLockstepClock(lockstep);
+    for (int i = 0; i < processes; i++) {
+        if ((int)rng.range(0, 99) < dist.short_pct) {
+            manager.addProcess(dist.short_min, dist.short_max);
+        }
+        else {
+            manager.addProcess(dist.long_min, dist.long_max);
+        }
+    }
+
+    SchedulerStats st;
+    do {
+        Sleep(100);
+        st = manager.stats();
+    } while (st.finished < (uint64_t)processes
+        && std::chrono::duration<double, std::milli>(Clock::now() - start).count() < duration_ms);
+
+    double cpu_ms = hostCpuMs() - cpu_start;
+
+    Row r;
+    r.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    r.mode = mode;
+    r.cores = cores;
+    r.quantum = quantum;
+    r.processes = processes;
+    r.distribution = dist.name;
+    r.st = st;
+    r.instr_per_sec = st.instructions / (r.elapsed_ms / 1000.0);
+    r.efficiency = (double)st.instructions / ((double)cores * (st.cycles + 1));
+    r.mean_wait = st.dispatches ? (double)st.dispatch_wait_total / st.dispatches : 0;
+    r.contention_pct = st.lock_acquisitions ? st.lock_contended * 100.0 / st.lock_acquisitions : 0;
+    r.peak_rss_kb = peakRssKb();
+    r.clock = lockstep ? "lockstep" : "realtime";
+    r.cpu_ms = cpu_ms;
+    r.cpu_us_per_instr = st.instructions ? cpu_ms * 1000.0 / st.instructions : 0;
+
+    printf("%s\n", toCsv(r).c_str());
+    fflush(stdout);
+
+    // Core threads are never joined; leave without running ~ScreenManager
+    manager.shutdown();
+    _Exit(0);
+}
+
+static std::vector<int> parseList(const char* text) {
+    std::vector<int> out;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int n = atoi(item.c_str());
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+/* parent side: run one configuration in a child and read back its row */
+static bool runChild(const std::string& exe, const std::string& mode, int cores, int quantum, int processes,
+    const Distribution& dist, int duration_ms, bool lockstep, std::string& row) {
+    std::ostringstream cmd;
+    // cmd.exe strips the outer pair of quotes, keeping the ones around the path
+    cmd << "\"\"" << exe << "\" --run " << mode << " " << cores << " " << quantum << " "
+        << processes << " " << dist.name << " " << duration_ms << " " << (lockstep ? "lockstep" : "realtime") << "\"";
+
+    FILE* pipe = _popen(cmd.str().c_str(), "r");
+    if (!pipe) return false;
+
+    char line[512];
+    row.clear();
+    while (fgets(line, sizeof(line), pipe)) {
+        row = line;
+    }
+    _pclose(pipe);
+
+    while (!row.empty() && (row.back() == '\n' || row.back() == '\r')) row.pop_back();
+    return !row.empty();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 9 && std::string(argv[1]) == "--run") {
+        const Distribution* dist = findDistribution(argv[6]);
+        if (!dist) return 1;
+        return runOne(argv[2], atoi(argv[3]), atoi(argv[4]), atoi(argv[5]), *dist, atoi(argv[7]), std::string(argv[8]) == "lockstep");
+    }
+
+    std::vector<int> core_counts = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+    std::vector<int> quanta = { 1, 5, 20 };
+    std::vector<int> process_counts = { 100, 1000, 10000 };
+    std::vector<const Distribution*> dists;
+    for (const Distribution& d : DISTRIBUTIONS) dists.push_back(&d);
+    int duration_ms = 2000;
+    bool lockstep = true;
+    std::string out_path = "scheduler_bench.csv";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--quick") {
+            core_counts = { 1, 4, 16, 64 };
+            quanta = { 5 };
+            process_counts = { 1000 };
+            dists = { findDistribution("mixed") };
+            duration_ms = 1000;
+        }
+        else if (arg == "--realtime") lockstep = false;
+        else if (arg == "--duration" && has_value) duration_ms = atoi(argv[++i]);
+        else if (arg == "--cores" && has_value) core_counts = parseList(argv[++i]);
+        else if (arg == "--quantum" && has_value) quanta = parseList(argv[++i]);
+        else if (arg == "--processes" && has_value) process_counts = parseList(argv[++i]);
+        else if (arg == "--out" && has_value) out_path = argv[++i];
+        else {
+            fprintf(stderr, "Usage: SchedulerBench [--quick] [--realtime] [--duration ms] [--cores 1,2,4] [--quantum 1,5] "
+                "[--processes 100,1000] [--out results.csv]\n");
+            return 1;
+        }
+    }
+
+    char exe[MAX_PATH];
+    if (!GetModuleFileNameA(NULL, exe, MAX_PATH)) {
+        fprintf(stderr, "Could not locate the benchmark executable\n");
+        return 1;
+    }
+
+    FILE* csv = fopen(out_path.c_str(), "w");
+    if (!csv) {
+        fprintf(stderr, "Could not write %s\n", out_path.c_str());
+        return 1;
+    }
+    fprintf(csv, "%s\n", CSV_HEADER);
+
+    // mode/cores -> every row for it, for the summary
+    std::map<std::pair<std::string, int>, std::vector<Row>> groups;
+
+    const char* modes[] = { "fcfs", "rr" };
+    for (const char* mode : modes) {
+        // fcfs ignores the quantum, so it runs once per point
+        std::vector<int> mode_quanta = std::string(mode) == "rr" ? quanta : std::vector<int>{ 0 };
+        for (int cores : core_counts) {
+            for (int quantum : mode_quanta) {
+                for (int processes : process_counts) {
+                    for (const Distribution* dist : dists) {
+                        std::string line;
+                        Row r;
+                        if (!runChild(exe, mode, cores, quantum, processes, *dist, duration_ms, lockstep, line) || !fromCsv(line, r)) {
+                            fprintf(stderr, "%-4s cores=%d quantum=%d processes=%d %s: run failed\n",
+                                mode, cores, quantum, processes, dist->name);
+                            continue;
+                        }
+                        fprintf(csv, "%s\n", line.c_str());
+                        fflush(csv);
+                        fprintf(stderr, "%-4s cores=%-3d quantum=%-2d processes=%-5d %-5s %10.0f instr/s\n",
+                            mode, cores, quantum, processes, dist->name, r.instr_per_sec);
+                        groups[std::make_pair(r.mode, r.cores)].push_back(r);
+                    }
+                }
+            }
+        }
+    }
+    fclose(csv);
+
+    printf("\n%-5s %6s %5s %14s %13s %11s %10s %11s %13s %13s\n",
+        "mode", "cores", "runs", "instr/s mean", "CPU us/instr", "efficiency", "mean wait", "migrations", "contention %", "peak RSS MB");
+    for (const auto& g : groups) {
+        const std::vector<Row>& rows = g.second;
+        double ips = 0, cpu = 0, eff = 0, wait = 0, contention = 0;
+        uint64_t migrations = 0, rss = 0;
+        for (const Row& r : rows) {
+            ips += r.instr_per_sec;
+            cpu += r.cpu_us_per_instr;
+            eff += r.efficiency;
+            wait += r.mean_wait;
+            migrations += r.st.migrations;
+            if (r.contention_pct > contention) contention = r.contention_pct;
+            if (r.peak_rss_kb > rss) rss = r.peak_rss_kb;
+        }
+        double n = (double)rows.size();
+        printf("%-5s %6d %5zu %14.0f %13.3f %11.3f %10.1f %11llu %13.3f %13.1f\n",
+            g.first.first.c_str(), g.first.second, rows.size(), ips / n, cpu / n, eff / n, wait / n,
+            (unsigned long long)migrations, contention, rss / 1024.0);
+    }
+    printf("\n%s clock; mean over every run at that point; contention and RSS are the worst run. Rows: %s\n",
+        lockstep ? "lockstep" : "realtime", out_path.c_str());
+    return 0;
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <Windows.h>
+#include "Process.h"
+
+/*
+ * Binary checkpoint of the whole emulator.
+ *
+ * File layout, little-endian:
+ *   CheckpointHeader
+ *   CheckpointCore    x cores       what each core runs, its rr counter, queue length
+ *   CheckpointQueued  x queued      every ready queue in order, core 0 first
+ *   text                            per process: custom name, creation time, logs ('\n' after each line)
+ *   CheckpointProcess x processes   fixed size, so restore can index them in place
+ *
+ * Everything except the text is copied while the scheduler is paused. The
+ * logs are append-only, so the background writer can copy the first
+ * <log_lines> of each process page by page while the cores keep running.
+ * The file is written under <path>.tmp and moved over <path> when complete;
+ * the section offsets in the header are patched in last.
+ */
+
+const uint32_t CHECKPOINT_MAGIC   = 0x4B435343;   // "CSCK"
+const uint16_t CHECKPOINT_VERSION = 1;
+
+// Pids are handed out densely from 0, so next_pid only runs ahead of the
+// process count by admissions in flight. Allowing one ProcessTable chunk of
+// slack keeps a damaged pid from making restore allocate the whole table.
+const uint32_t CHECKPOINT_PID_SLACK = 1 << 16;
+
+#pragma pack(push, 1)
+struct CheckpointHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cores;
+    uint8_t  scheduler;         // 0 = fcfs, 1 = rr
+    uint8_t  reserved[3];
+    uint32_t quantum;
+    uint32_t delay;
+    uint64_t seed;
+    uint64_t cycle;             // simulation clock when taken
+    int32_t  next_pid;
+    uint32_t processes;
+    uint64_t queued;
+    uint64_t migrations;
+    uint64_t queues_offset;
+    uint64_t text_offset;
+    uint64_t process_offset;
+    uint64_t file_size;
+};
+
+struct CheckpointCore {
+    int32_t  running;           // pid on the core, -1 = idle
+    uint32_t slice_used;        // rr quantum counter
+    uint32_t queued;            // length of this core's ready queue
+};
+
+struct CheckpointQueued {
+    int32_t  pid;
+    uint64_t since;             // tick it was queued
+};
+
+struct CheckpointProcess {
+    int32_t  pid;
+    int32_t  line;
+    int32_t  total;
+    uint8_t  status;
+    uint8_t  reserved;
+    int16_t  last_core;
+    uint64_t rng;
+    uint64_t wake_at;           // WAITING only
+    uint64_t text;              // offset of this process' text from text_offset
+    uint32_t name_len;          // 0 = generated name
+    uint32_t created_len;
+    uint32_t log_lines;
+    uint64_t log_bytes;
+};
+#pragma pack(pop)
+
+/* what the paused scheduler hands to the background writer */
+struct CheckpointImage {
+    CheckpointHeader header = {};
+    std::vector<CheckpointCore> cores;
+    std::vector<CheckpointQueued> queued;
+    std::vector<CheckpointProcess> processes;
+    std::vector<ScreenFactory*> screens;    // same order as <processes>
+    std::vector<std::string> names;         // custom names, "" for generated ones
+    std::vector<std::string> created;
+};
+
+/* streams <image> to <path>; returns false if the file could not be written */
+inline bool writeCheckpoint(const std::string& path, CheckpointImage& image, uint64_t& bytes) {
+    static const size_t LOG_PAGE = 256;             // lines copied per log lock
+    static const size_t FLUSH_AT = 1 << 20;
+
+    std::string tmp = path + ".tmp";
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    CheckpointHeader& h = image.header;
+    uint64_t offset = 0;
+    auto put = [&](const void* data, size_t n) {
+        file.write(static_cast<const char*>(data), n);
+        offset += n;
+    };
+
+    put(&h, sizeof(h));                             // offsets patched below
+    put(image.cores.data(), image.cores.size() * sizeof(CheckpointCore));
+    h.queues_offset = offset;
+    put(image.queued.data(), image.queued.size() * sizeof(CheckpointQueued));
+
+    h.text_offset = offset;
+    std::string buf;
+    buf.reserve(FLUSH_AT + 64 * 1024);
+    uint64_t text = 0;
+    for (size_t i = 0; i < image.processes.size(); i++) {
+        CheckpointProcess& rec = image.processes[i];
+        rec.text = text + buf.size();
+        buf += image.names[i];
+        buf += image.created[i];
+
+        size_t logs_from = buf.size();
+        size_t from = 0;
+        while (from < rec.log_lines) {
+            size_t next = image.screens[i]->appendLogs(from, std::min<size_t>(rec.log_lines, from + LOG_PAGE), buf);
+            if (next == from) break;
+            from = next;
+
+            if (buf.size() >= FLUSH_AT) {
+                rec.log_bytes += buf.size() - logs_from;
+                logs_from = 0;
+                text += buf.size();
+                put(buf.data(), buf.size());
+                buf.clear();
+            }
+        }
+        rec.log_bytes += buf.size() - logs_from;
+        rec.log_lines = (uint32_t)from;
+    }
+    text += buf.size();
+    put(buf.data(), buf.size());
+
+    h.process_offset = offset;
+    put(image.processes.data(), image.processes.size() * sizeof(CheckpointProcess));
+    h.file_size = offset;
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.close();
+    if (file.fail()) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    // replaces <path> in one step, so a crash leaves either the old or the new checkpoint
+    if (!MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    bytes = offset;
+    return true;
+}
+
+/*
+ * Read-only memory map of a checkpoint. open() validates every section
+ * against the file size, and every pid and status, up front, so neither
+ * the accessors nor Scheduler::restore() have to.
+ */
+class CheckpointFile {
+private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    const char* base = nullptr;
+    uint64_t size = 0;
+    CheckpointHeader h = {};
+
+    template <typename T>
+    T at(uint64_t offset) const {
+        T value;
+        memcpy(&value, base + offset, sizeof(T));
+        return value;
+    }
+
+    bool validate() {
+        if (size < sizeof(h)) return false;
+        h = at<CheckpointHeader>(0);
+        if (h.magic != CHECKPOINT_MAGIC || h.version != CHECKPOINT_VERSION || h.file_size != size) return false;
+
+        uint64_t cores_end = sizeof(h) + (uint64_t)h.cores * sizeof(CheckpointCore);
+        if (h.queues_offset != cores_end) return false;
+        if (h.text_offset != h.queues_offset + h.queued * sizeof(CheckpointQueued)) return false;
+        if (h.process_offset < h.text_offset || h.process_offset > size) return false;
+        if (size - h.process_offset != (uint64_t)h.processes * sizeof(CheckpointProcess)) return false;
+
+        uint64_t listed = 0;
+        for (int i = 0; i < h.cores; i++) listed += core(i).queued;
+        if (listed != h.queued) return false;
+        if (h.next_pid < 0 || (uint64_t)h.next_pid > (uint64_t)h.processes + CHECKPOINT_PID_SLACK) return false;
+
+        uint64_t text_size = h.process_offset - h.text_offset;
+        std::vector<int32_t> pids(h.processes);
+        for (uint32_t i = 0; i < h.processes; i++) {
+            CheckpointProcess p = process(i);
+            uint64_t len = (uint64_t)p.name_len + p.created_len + p.log_bytes;
+            if (p.pid < 0 || p.text > text_size || len > text_size - p.text) return false;
+            if (p.status > TERMINATED || p.line < 0 || p.line > p.total) return false;
+            if (p.pid >= h.next_pid || p.log_lines > p.log_bytes) return false;     // every log line ends in '\n'
+            pids[i] = p.pid;
+        }
+
+        // every pid a core runs or queues must be one of the processes, each listed once
+        std::sort(pids.begin(), pids.end());
+        if (std::adjacent_find(pids.begin(), pids.end()) != pids.end()) return false;
+        auto known = [&](int32_t pid) { return std::binary_search(pids.begin(), pids.end(), pid); };
+        for (int i = 0; i < h.cores; i++) {
+            int32_t running = core(i).running;
+            if (running != -1 && !known(running)) return false;
+        }
+        for (uint64_t i = 0; i < h.queued; i++) {
+            if (!known(queued(i).pid)) return false;
+        }
+        return true;
+    }
+
+public:
+    CheckpointFile() {}
+    ~CheckpointFile() { close(); }
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length) || length.QuadPart < (LONGLONG)sizeof(h)) {
+            close();
+            return false;
+        }
+        size = (uint64_t)length.QuadPart;
+
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            base = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (base == nullptr || !validate()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base) UnmapViewOfFile(base);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        base = nullptr;
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+        size = 0;
+    }
+
+    const CheckpointHeader& header() const { return h; }
+
+    CheckpointCore core(int i) const {
+        return at<CheckpointCore>(sizeof(h) + (uint64_t)i * sizeof(CheckpointCore));
+    }
+
+    CheckpointQueued queued(uint64_t i) const {
+        return at<CheckpointQueued>(h.queues_offset + i * sizeof(CheckpointQueued));
+    }
+
+    CheckpointProcess process(uint32_t i) const {
+        return at<CheckpointProcess>(h.process_offset + (uint64_t)i * sizeof(CheckpointProcess));
+    }
+
+    /* start of a process' text: name, then creation time, then logs */
+    const char* text(const CheckpointProcess& p) const {
+        return base + h.text_offset + p.text;
+    }
+};
@@ -1,25 +1,39 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <ctime>
+#include <cstdint>
+#include <mutex>
 
 class ConfigException : public std::runtime_error {
 public:
     explicit ConfigException(const std::string& message) : std::runtime_error(message) {}
 };
 
+/* one complete, validated set of parameters; anything missing from the file keeps its default */
+struct ConfigValues {
+    int numCPU = 4;                       // Range: [1, 128]
+    std::string scheduler_type = "rr";    // Options: "fcfs" or "rr"
+    uint32_t quantum_cycles = 5;          // Range: [1, 2^32]
+    uint32_t batch_process_freq = 1;      // Range: [1, 2^32]
+    uint32_t min_ins = 1000;              // Range: [1, 2^32]
+    uint32_t max_ins = 2000;              // Range: [min-ins, 2^32]
+    uint32_t delay_per_exec = 0;          // Range: [0, 2^32]
+    uint64_t random_seed = 0;             // Defaults to the current time
+    std::string trace_file;               // Empty = no trace
+
+    std::vector<std::string> defaulted;   // parameters that were not in the file
+};
+
 class Config {
 private:
-    int numCPU;                // Range: [1, 128]
-    std::string scheduler_type; // Options: "fcfs" or "rr"
-    uint32_t quantum_cycles;    // Range: [1, 2^32]
-    uint32_t batch_process_freq; // Range: [1, 2^32]
-    uint32_t min_ins;  // Range: [1, 2^32]
-    uint32_t max_ins;  // Range: [1, 2^32]
-    uint32_t delay_per_exec;    // Range: [0, 2^32]
+    ConfigValues values;
+    mutable std::mutex config_mx;   // values are swapped whole by reconfigure
     bool initialized = false;
 
     static Config* instancePtr;
@@ -33,108 +47,164 @@ public:
         return instancePtr;
     }
 
+    static ConfigValues parseFile(const std::string& filename);
+
     void loadConfig(const std::string& filename);
-    void validateParameters();
+    void apply(const ConfigValues& next);
+    ConfigValues snapshot() const;
+
     bool isInitialized() const { return initialized; }
-    int getNumCPU() const { return numCPU; }
-    const std::string& getSchedulerType() const { return scheduler_type; }
-    uint32_t getQuantumCycles() const { return quantum_cycles; }
-    uint32_t getBatchProcessFreq() const { return batch_process_freq; }
-    uint32_t getMinIns() const { return min_ins; }
-    uint32_t getMaxIns() const { return max_ins; }
-    uint32_t getDelayPerExec() const { return delay_per_exec; }
+
+    // Single fields lock only long enough to read that field; use snapshot()
+    // when several values have to come from the same reconfigure
+    int getNumCPU() const { std::lock_guard<std::mutex> g(config_mx); return values.numCPU; }
+    std::string getSchedulerType() const { std::lock_guard<std::mutex> g(config_mx); return values.scheduler_type; }
+    uint32_t getQuantumCycles() const { std::lock_guard<std::mutex> g(config_mx); return values.quantum_cycles; }
+    uint32_t getBatchProcessFreq() const { std::lock_guard<std::mutex> g(config_mx); return values.batch_process_freq; }
+    uint32_t getMinIns() const { std::lock_guard<std::mutex> g(config_mx); return values.min_ins; }
+    uint32_t getMaxIns() const { std::lock_guard<std::mutex> g(config_mx); return values.max_ins; }
+    uint32_t getDelayPerExec() const { std::lock_guard<std::mutex> g(config_mx); return values.delay_per_exec; }
+    uint64_t getRandomSeed() const { std::lock_guard<std::mutex> g(config_mx); return values.random_seed; }
+    std::string getTraceFile() const { std::lock_guard<std::mutex> g(config_mx); return values.trace_file; }
 };
 
 Config* Config::instancePtr = nullptr;
 
-void Config::loadConfig(const std::string& filename) {
+/*
+ * Line-based "key value" format. '#' starts a comment, blank lines are
+ * skipped, and every error names the file and line it came from.
+ */
+ConfigValues Config::parseFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw ConfigException("Could not open config file: " + filename);
     }
 
-    std::map<std::string, bool> requiredParams = { // For missing parameters
-        {"num-cpu", false},
-        {"scheduler", false},
-        {"quantum-cycles", false},
-        {"batch-process-freq", false},
-        {"min-ins", false},
-        {"max-ins", false},
-        {"delay-per-exec", false}
+    ConfigValues v;
+    v.random_seed = (uint64_t)time(0);
+
+    std::map<std::string, int> seen = { // parameter -> line it was set on
+        {"num-cpu", 0},
+        {"scheduler", 0},
+        {"quantum-cycles", 0},
+        {"batch-process-freq", 0},
+        {"min-ins", 0},
+        {"max-ins", 0},
+        {"delay-per-exec", 0},
+        {"random-seed", 0},
+        {"trace-file", 0}
     };
 
-    std::string param;
-    while (file >> param) {
-        if (param == "num-cpu") {
-            file >> numCPU;
-            requiredParams[param] = true;
+    std::string line;
+    int lineNo = 0;
+
+    auto fail = [&](int at, const std::string& message) {
+        throw ConfigException(filename + ":" + std::to_string(at) + ": " + message);
+    };
+
+    auto number = [&](const std::string& key, const std::string& text, uint64_t lo, uint64_t hi) {
+        size_t used = 0;
+        uint64_t n = 0;
+        try {
+            if (text.empty() || text[0] == '-' || text[0] == '+') throw std::invalid_argument(text);
+            n = std::stoull(text, &used);
         }
-        else if (param == "scheduler") {
-            file >> scheduler_type;
-            requiredParams[param] = true;
+        catch (const std::exception&) {
+            fail(lineNo, "expected a non-negative integer for " + key + ", got '" + text + "'");
         }
-        else if (param == "quantum-cycles") {
-            file >> quantum_cycles;
-            requiredParams[param] = true;
+        if (used != text.size()) {
+            fail(lineNo, "expected a non-negative integer for " + key + ", got '" + text + "'");
         }
-        else if (param == "batch-process-freq") {
-            file >> batch_process_freq;
-            requiredParams[param] = true;
+        if (n < lo || n > hi) {
+            fail(lineNo, key + " must be between " + std::to_string(lo) + " and " + std::to_string(hi) + ", got " + text);
         }
-        else if (param == "min-ins") {
-            file >> min_ins;
-            requiredParams[param] = true;
+        return n;
+    };
+
+    while (std::getline(file, line)) {
+        lineNo++;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream ss(line);
+        std::string key, value, extra;
+        if (!(ss >> key)) continue;
+
+        auto it = seen.find(key);
+        if (it == seen.end()) {
+            fail(lineNo, "unknown parameter: " + key);
         }
-        else if (param == "max-ins") {
-            file >> max_ins;
-            requiredParams[param] = true;
+        if (it->second != 0) {
+            fail(lineNo, "duplicate parameter: " + key + " (first set on line " + std::to_string(it->second) + ")");
         }
-        else if (param == "delay-per-exec") {
-            file >> delay_per_exec;
-            requiredParams[param] = true;
+        if (!(ss >> value)) {
+            fail(lineNo, "missing value for " + key);
         }
-        else {
-            throw ConfigException("Unknown parameter: " + param);
+        if (ss >> extra) {
+            fail(lineNo, "unexpected text after the value of " + key + ": " + extra);
         }
-    }
-
-    // Check if all required parameters were found
-    for (const auto& param : requiredParams) {
-        if (!param.second) {
-            throw ConfigException("Missing required parameter: " + param.first);
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
         }
-    }
-
-    validateParameters();
-    initialized = true;
-}
+        it->second = lineNo;
 
-void Config::validateParameters() {
-    if (numCPU < 1 || numCPU > 128) {
-        throw ConfigException("Invalid number of CPUs (must be between 1 and 128): " + std::to_string(numCPU));
-    }
-
-    if (scheduler_type != "fcfs" && scheduler_type != "rr") {
-        throw ConfigException("Invalid scheduler type (must be either 'fcfs' or 'rr'): " + scheduler_type);
+        if (key == "num-cpu") {
+            v.numCPU = (int)number(key, value, 1, 128);
+        }
+        else if (key == "scheduler") {
+            if (value != "fcfs" && value != "rr") {
+                fail(lineNo, "scheduler must be either 'fcfs' or 'rr', got '" + value + "'");
+            }
+            v.scheduler_type = value;
+        }
+        else if (key == "quantum-cycles") {
+            v.quantum_cycles = (uint32_t)number(key, value, 1, UINT32_MAX);
+        }
+        else if (key == "batch-process-freq") {
+            v.batch_process_freq = (uint32_t)number(key, value, 1, UINT32_MAX);
+        }
+        else if (key == "min-ins") {
+            v.min_ins = (uint32_t)number(key, value, 1, UINT32_MAX);
+        }
+        else if (key == "max-ins") {
+            v.max_ins = (uint32_t)number(key, value, 1, UINT32_MAX);
+        }
+        else if (key == "delay-per-exec") {
+            v.delay_per_exec = (uint32_t)number(key, value, 0, UINT32_MAX);
+        }
+        else if (key == "random-seed") {
+            v.random_seed = number(key, value, 0, UINT64_MAX);
+        }
+        else if (key == "trace-file") {
+            v.trace_file = value;
+        }
     }
 
-    if (quantum_cycles < 1) {
-        throw ConfigException("Invalid quantum cycles (must be at least 1): " + std::to_string(quantum_cycles));
+    if (v.max_ins < v.min_ins) {
+        int at = seen["max-ins"] ? seen["max-ins"] : seen["min-ins"];
+        fail(at, "max-ins (" + std::to_string(v.max_ins) + ") must be greater than or equal to min-ins (" + std::to_string(v.min_ins) + ")");
     }
 
-    if (batch_process_freq < 1) {
-        throw ConfigException("Invalid batch process frequency (must be at least 1): " + std::to_string(batch_process_freq));
+    for (const auto& param : seen) {
+        if (param.second == 0 && param.first != "random-seed" && param.first != "trace-file") {
+            v.defaulted.push_back(param.first);
+        }
     }
+    return v;
+}
 
-    if (min_ins < 1) {
-        throw ConfigException("Invalid minimum instructions (must be at least 1): " + std::to_string(min_ins));
-    }
+void Config::loadConfig(const std::string& filename) {
+    apply(parseFile(filename));
+    initialized = true;
+}
 
-    if (max_ins < min_ins) {
-        throw ConfigException("Invalid maximum instructions (must be greater than or equal to min-ins): " + std::to_string(max_ins));
-    }
+void Config::apply(const ConfigValues& next) {
+    std::lock_guard<std::mutex> g(config_mx);
+    values = next;
+}
 
-    if (delay_per_exec < 0) {
-        throw ConfigException("Invalid delays per execution (must be non-negative): " + std::to_string(delay_per_exec));
-    }
+ConfigValues Config::snapshot() const {
+    std::lock_guard<std::mutex> g(config_mx);
+    return values;
 }
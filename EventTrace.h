@@ -0,0 +1,220 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+
+/*
+ * Compact binary scheduling trace.
+ *
+ * File layout: one TraceHeader followed by a flat array of TraceEvent
+ * records, all little-endian, stamped with the simulation clock. Events
+ * are written in per-producer batches, so the file is only ordered within
+ * a producer; load() sorts by cycle. The ARRIVAL events alone are enough
+ * to rebuild a run's workload, which is what the "replay" command feeds
+ * back into a fresh ScreenManager.
+ */
+
+enum TraceEventType : uint8_t {
+    EV_ARRIVAL,     // arg = total instructions
+    EV_DISPATCH,
+    EV_PREEMPT,
+    EV_BLOCK,       // arg = ticks blocked
+    EV_WAKE,
+    EV_TERMINATE,
+    EV_MIGRATE      // core = from, arg = to
+};
+
+const uint32_t TRACE_MAGIC   = 0x52545343;   // "CSTR"
+const uint16_t TRACE_VERSION = 2;
+
+#pragma pack(push, 1)
+struct TraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cores;
+    uint64_t seed;
+    uint32_t quantum;
+    uint32_t delay;
+    uint8_t  scheduler;     // 0 = fcfs, 1 = rr
+    uint8_t  reserved[3];
+    uint32_t dropped;       // events lost to full buffers, patched in on close
+};
+
+struct TraceEvent {
+    uint64_t cycle;
+    uint32_t pid;
+    uint32_t arg;
+    int16_t  core;          // -1 when not tied to a core
+    uint8_t  type;
+    uint8_t  reserved;
+};
+#pragma pack(pop)
+
+/*
+ * order of events that share a cycle: a process becomes ready before it is
+ * dispatched. Everything else keeps its producer's order (load() sorts
+ * stably), since a core dispatches and then blocks, preempts or finishes a
+ * process within one pass.
+ */
+inline int traceEventRank(uint8_t type) {
+    switch (type) {
+    case EV_ARRIVAL:
+    case EV_WAKE:      return 0;
+    default:           return 1;
+    }
+}
+
+/*
+ * Fixed-size single-producer / single-consumer ring. The producer never
+ * blocks: when the flusher falls behind, new events are dropped and counted.
+ */
+class TraceRing {
+public:
+    static const uint32_t CAPACITY = 1 << 12;
+
+private:
+    TraceEvent slots[CAPACITY];
+    alignas(64) std::atomic<uint32_t> head{ 0 };    // next slot to write, owned by the producer
+    alignas(64) std::atomic<uint32_t> tail{ 0 };    // next slot to read, owned by the flusher
+
+public:
+    bool push(const TraceEvent& ev) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == CAPACITY) return false;
+        slots[h & (CAPACITY - 1)] = ev;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drain(std::vector<TraceEvent>& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        for (; t != h; t++) {
+            out.push_back(slots[t & (CAPACITY - 1)]);
+        }
+        tail.store(t, std::memory_order_release);
+    }
+};
+
+class EventTrace {
+private:
+    static const int FLUSH_MS = 5;
+
+    std::ofstream file;
+    TraceHeader header = {};
+    std::vector<std::unique_ptr<TraceRing>> rings;   // one per producer thread, the last one shared
+    std::mutex shared_mx;                             // serializes producers of the shared ring
+    std::atomic<uint32_t> dropped{ 0 };
+    std::atomic<bool> enabled{ false };
+    std::thread flusher;
+    std::mutex trace_mx;                              // guards open / close
+
+    void flushAll(std::vector<TraceEvent>& batch) {
+        for (auto& ring : rings) {
+            ring->drain(batch);
+        }
+        if (!batch.empty()) {
+            file.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(TraceEvent));
+            batch.clear();
+        }
+    }
+
+    void flushJob() {
+        std::vector<TraceEvent> batch;
+        batch.reserve(TraceRing::CAPACITY);
+        while (enabled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_MS));
+            flushAll(batch);
+        }
+        flushAll(batch);
+    }
+
+    void push(TraceRing& ring, uint8_t type, uint64_t cycle, uint32_t pid, int core, uint32_t arg) {
+        TraceEvent ev;
+        ev.cycle = cycle;
+        ev.pid = pid;
+        ev.arg = arg;
+        ev.core = (int16_t)core;
+        ev.type = type;
+        ev.reserved = 0;
+        if (!ring.push(ev)) dropped++;
+    }
+
+public:
+    ~EventTrace() { close(); }
+
+    /* <producers> dedicated rings (e.g. one per core thread) plus one shared ring */
+    bool open(const std::string& path, const TraceHeader& hdr, int producers) {
+        std::lock_guard<std::mutex> g(trace_mx);
+        if (enabled) return false;
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        header = hdr;
+        header.dropped = 0;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        rings.clear();
+        for (int i = 0; i <= producers; i++) {
+            rings.push_back(std::unique_ptr<TraceRing>(new TraceRing()));
+        }
+        dropped = 0;
+        enabled = true;
+        flusher = std::thread(&EventTrace::flushJob, this);
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    /* lock-free; only the thread that owns <producer> may call this */
+    void record(int producer, uint8_t type, uint64_t cycle, uint32_t pid, int core, uint32_t arg = 0) {
+        if (!enabled) return;
+        push(*rings[producer], type, cycle, pid, core, arg);
+    }
+
+    /* for threads without a ring of their own */
+    void recordShared(uint8_t type, uint64_t cycle, uint32_t pid, int core, uint32_t arg = 0) {
+        if (!enabled) return;
+        std::lock_guard<std::mutex> g(shared_mx);
+        push(*rings.back(), type, cycle, pid, core, arg);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> g(trace_mx);
+        if (!enabled) return;
+        enabled = false;
+        flusher.join();
+
+        header.dropped = dropped;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+    }
+
+    /* read a whole trace back, sorted by cycle; false if the file is missing or not a trace */
+    static bool load(const std::string& path, TraceHeader& header, std::vector<TraceEvent>& events) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) return false;
+
+        TraceEvent ev;
+        while (in.read(reinterpret_cast<char*>(&ev), sizeof(ev))) {
+            events.push_back(ev);
+        }
+
+        std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+            if (a.cycle != b.cycle) return a.cycle < b.cycle;
+            return traceEventRank(a.type) < traceEventRank(b.type);
+        });
+        return true;
+    }
+};
@@ -7,6 +7,8 @@
 #include <conio.h>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <memory>
 
 int cpu_cycles = 0;
 bool running = true;
@@ -21,6 +23,13 @@ std::thread main_worker(mainThread);
 std::thread scheduler_start_thread;
 std::thread cpu_cycle(cpuCycle);
 std::atomic<bool> making_process(false);
+std::thread config_watch_thread;
+std::atomic<bool> watching_config(false);
+std::mutex reconfigure_mutex;
+std::thread checkpoint_thread;
+std::atomic<bool> checkpointing(false);
+
+const char* CONFIG_FILE = "config.txt";
 
 // Clear screen function
 void Clear() {
@@ -43,9 +52,11 @@ void initializeScreens() {
     int RR = 0;
     if (config->getSchedulerType() == "rr") RR = 1;
 
-    screens = new ScreenManager(config->getNumCPU(), config->getDelayPerExec(), config->getQuantumCycles(), RR);
+    screens = new ScreenManager(config->getNumCPU(), config->getDelayPerExec(), config->getQuantumCycles(), RR, config->getRandomSeed());
     if (screens) {
-        
+        if (!config->getTraceFile().empty() && !screens->startTrace(config->getTraceFile())) {
+            std::cout << "Could not open trace file: " << config->getTraceFile() << "\n";
+        }
     }
     else {
         std::cout << "Failed to initialize ScreenManager.\n"; 
@@ -77,8 +88,13 @@ void Screen(std::vector<std::string> inputBuffer) {
                 std::cout << "Screen with the name: [" << name << "] already exists.\n";
             }
             else {
-                screens->addScreen(name, config->getMinIns(), config->getMaxIns());
-                screens->isInsideScreen(true);
+                ConfigValues values = config->snapshot();   // min/max from the same reconfigure
+                if (screens->addScreen(name, values.min_ins, values.max_ins) < 0) {
+                    std::cout << "Names of the form Process_<number> are reserved for generated processes.\n";
+                }
+                else {
+                    screens->isInsideScreen(true);
+                }
             }
         }
         else {
@@ -90,16 +106,21 @@ void Screen(std::vector<std::string> inputBuffer) {
     }
 }
 
-void SchedulerStart(int batch_process_freq, int min_ins, int max_ins) {
+void SchedulerStart() {
     std::cout << "scheduler-start command recognized. Starting process generation.\n";
     if (!making_process.load()) {
         making_process.store(true);
+        if (scheduler_start_thread.joinable()) {
+            scheduler_start_thread.join(); // a finished replay
+        }
         scheduler_start_thread = std::thread([=]() {
-            int process_count = 0;
             while (making_process.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(batch_process_freq*1000));
-                std::string process_name = "Process_" + std::to_string(process_count++);
-                screens->addScreen(process_name, min_ins, max_ins);
+                // Paced on the simulation clock so arrivals land on the same cycles every run.
+                // Re-read every batch so a reconfigure applies to the next one.
+                screens->waitCycles((uint64_t)config->getBatchProcessFreq() * 1000);
+                if (!making_process.load()) break;
+                ConfigValues values = config->snapshot();
+                screens->addProcess(values.min_ins, values.max_ins);
             }
             });
     }
@@ -108,6 +129,125 @@ void SchedulerStart(int batch_process_freq, int min_ins, int max_ins) {
     }
 }
 
+void Replay(const std::string& path) {
+    TraceHeader header;
+    std::vector<TraceEvent> events;
+    if (!EventTrace::load(path, header, events)) {
+        std::cout << "Could not read trace file: " << path << "\n";
+        return;
+    }
+    if (making_process.load()) {
+        std::cout << "Scheduler is already running.\n";
+        return;
+    }
+    if (screens->processCount() > 0) {
+        std::cout << "Replay needs a freshly initialized emulator with no processes.\n";
+        return;
+    }
+
+    std::vector<TraceEvent> arrivals;
+    for (const TraceEvent& ev : events) {
+        if (ev.type == EV_ARRIVAL) arrivals.push_back(ev);
+    }
+
+    std::cout << "Replaying " << arrivals.size() << " arrivals (seed " << header.seed << ", recorded under "
+        << (header.scheduler ? "rr" : "fcfs") << ") with scheduler " << config->getSchedulerType() << ".\n";
+
+    making_process.store(true);
+    if (scheduler_start_thread.joinable()) {
+        scheduler_start_thread.join();
+    }
+    scheduler_start_thread = std::thread([=]() {
+        uint64_t base = screens->getCycle();
+        uint64_t first = arrivals.empty() ? 0 : arrivals[0].cycle;
+        for (const TraceEvent& ev : arrivals) {
+            if (!making_process.load()) break;
+            screens->waitUntilCycle(base + (ev.cycle - first));
+            screens->addReplayed(ev.pid, ev.arg, header.seed);
+        }
+        making_process.store(false);
+        });
+}
+
+/*
+ * Pauses the cores just long enough to copy the scheduler state, then writes
+ * the file (logs included) from a background thread while the run goes on.
+ */
+void Checkpoint(const std::string& path) {
+    if (checkpointing.load()) {
+        std::cout << "A checkpoint is still being written.\n";
+        return;
+    }
+    if (checkpoint_thread.joinable()) {
+        checkpoint_thread.join();
+    }
+
+    std::shared_ptr<CheckpointImage> image(new CheckpointImage());
+    auto start = std::chrono::steady_clock::now();
+    screens->captureCheckpoint(*image);
+    auto paused = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Checkpoint of " << image->header.processes << " processes taken at cycle " << image->header.cycle
+        << " (cores paused " << paused.count() << " ms), writing " << path << " in the background.\n";
+
+    checkpointing.store(true);
+    checkpoint_thread = std::thread([=]() {
+        uint64_t bytes = 0;
+        if (writeCheckpoint(path, *image, bytes)) {
+            std::cout << "\nCheckpoint written to " << path << " (" << bytes / 1024 << " KB).\n";
+        }
+        else {
+            std::cout << "\nCould not write checkpoint file: " << path << "\n";
+        }
+        checkpointing.store(false);
+        });
+}
+
+void Restore(const std::string& path) {
+    if (making_process.load()) {
+        std::cout << "Scheduler is already running.\n";
+        return;
+    }
+    if (screens->processCount() > 0) {
+        std::cout << "Restore needs a freshly initialized emulator with no processes.\n";
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CheckpointFile ck;
+    if (!ck.open(path)) {
+        std::cout << "Could not read checkpoint file: " << path << "\n";
+        return;
+    }
+
+    const CheckpointHeader& h = ck.header();
+    std::string scheduler = h.scheduler ? "rr" : "fcfs";
+    if (h.cores != config->getNumCPU() || scheduler != config->getSchedulerType()) {
+        std::cout << "Checkpoint was taken with num-cpu " << h.cores << " and scheduler " << scheduler
+            << "; set the same in " << CONFIG_FILE << " and restart.\n";
+        return;
+    }
+
+    size_t restored = 0;
+    try {
+        restored = screens->restore(ck);
+    }
+    catch (const std::bad_alloc&) {
+        std::cout << "Not enough memory to restore " << path << ".\n";
+        return;
+    }
+    auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Restored " << restored << " processes at cycle " << h.cycle << " in " << took.count() << " ms.\n";
+    if (h.quantum != config->getQuantumCycles() || h.delay != config->getDelayPerExec()) {
+        std::cout << "Using quantum-cycles " << config->getQuantumCycles() << " and delay-per-exec " << config->getDelayPerExec()
+            << " from " << CONFIG_FILE << " (checkpoint had " << h.quantum << " and " << h.delay << ").\n";
+    }
+    if (h.seed != config->getRandomSeed()) {
+        std::cout << "Using random-seed " << h.seed << " from the checkpoint (" << CONFIG_FILE << " has "
+            << config->getRandomSeed() << ").\n";
+    }
+}
+
 void SchedulerStop() {
     std::cout << "scheduler-stop command recognized. Stopping process generation.\n";
     making_process.store(false);
@@ -116,7 +256,130 @@ void SchedulerStop() {
     }
 }
 
+void printConfig(const ConfigValues& v) {
+    auto mark = [&](const std::string& key) {
+        for (const std::string& d : v.defaulted) {
+            if (d == key) return " (default)";
+        }
+        return "";
+    };
+
+    std::cout << "Configuration values:\n";
+    std::cout << "  num-cpu: " << v.numCPU << mark("num-cpu") << "\n";
+    std::cout << "  scheduler: " << v.scheduler_type << mark("scheduler") << "\n";
+    std::cout << "  quantum-cycles: " << v.quantum_cycles << mark("quantum-cycles") << "\n";
+    std::cout << "  batch-process-freq: " << v.batch_process_freq << mark("batch-process-freq") << "\n";
+    std::cout << "  min-ins: " << v.min_ins << mark("min-ins") << "\n";
+    std::cout << "  max-ins: " << v.max_ins << mark("max-ins") << "\n";
+    std::cout << "  delay-per-exec: " << v.delay_per_exec << mark("delay-per-exec") << "\n";
+    std::cout << "  random-seed: " << v.random_seed << "\n";
+    if (!v.trace_file.empty()) {
+        std::cout << "  trace-file: " << v.trace_file << "\n";
+    }
+}
+
+/*
+ * Re-reads config.txt and applies it to the running emulator in one step.
+ * quantum-cycles and delay-per-exec reach the cores on their next instruction;
+ * batch-process-freq, min-ins and max-ins apply from the next generated batch.
+ * num-cpu and scheduler would need new core threads, so a file that changes
+ * them is rejected as a whole.
+ */
+void Reconfigure() {
+    std::lock_guard<std::mutex> lock(reconfigure_mutex);
+    try {
+        ConfigValues next = Config::parseFile(CONFIG_FILE);
+        ConfigValues current = config->snapshot();
+
+        if (next.numCPU != current.numCPU || next.scheduler_type != current.scheduler_type) {
+            std::cout << "num-cpu and scheduler can't change while the emulator is running; configuration unchanged.\n";
+            return;
+        }
+
+        // Fixed for the lifetime of the run
+        next.random_seed = current.random_seed;
+        next.trace_file = current.trace_file;
+
+        int changed = 0;
+        auto report = [&](const char* key, uint32_t from, uint32_t to) {
+            if (from == to) return;
+            std::cout << "  " << key << ": " << from << " -> " << to << "\n";
+            changed++;
+        };
+        std::cout << "Reconfigured from " << CONFIG_FILE << ":\n";
+        report("quantum-cycles", current.quantum_cycles, next.quantum_cycles);
+        report("batch-process-freq", current.batch_process_freq, next.batch_process_freq);
+        report("min-ins", current.min_ins, next.min_ins);
+        report("max-ins", current.max_ins, next.max_ins);
+        report("delay-per-exec", current.delay_per_exec, next.delay_per_exec);
+        if (changed == 0) {
+            std::cout << "  (no changes)\n";
+        }
+
+        config->apply(next);
+        screens->reconfigure(next.quantum_cycles, next.delay_per_exec);
+    }
+    catch (const ConfigException& e) {
+        std::cerr << "Configuration error: " << e.what() << "\nConfiguration unchanged.\n";
+    }
+}
+
+/* reconfigures whenever config.txt is written; uses directory change notifications */
+void WatchConfig() {
+    std::cout << "Watching " << CONFIG_FILE << " for changes.\n";
+    if (config_watch_thread.joinable()) {
+        config_watch_thread.join(); // a watcher that gave up
+    }
+    watching_config.store(true);
+    config_watch_thread = std::thread([]() {
+        HANDLE change = FindFirstChangeNotificationA(".", FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
+        if (change == INVALID_HANDLE_VALUE) {
+            std::cout << "Could not watch the current directory for changes.\n";
+            watching_config.store(false);
+            return;
+        }
+
+        std::string last_contents;
+        auto contents = [&]() {
+            std::ifstream in(CONFIG_FILE);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        };
+        last_contents = contents();
+
+        while (watching_config.load()) {
+            // Time out regularly so "reconfigure unwatch" is honoured promptly
+            if (WaitForSingleObject(change, 250) != WAIT_OBJECT_0) continue;
+
+            // Other files in the directory trigger this too, and editors often
+            // write in several steps; give the write a moment to settle
+            Sleep(50);
+            std::string now = contents();
+            if (now != last_contents) {
+                last_contents = now;
+                std::cout << "\n";
+                Reconfigure();
+            }
+            FindNextChangeNotification(change);
+        }
+        FindCloseChangeNotification(change);
+        });
+}
+
+void UnwatchConfig() {
+    watching_config.store(false);
+    if (config_watch_thread.joinable()) {
+        config_watch_thread.join();
+    }
+}
+
 void Exit() {
+    UnwatchConfig();
+    if (checkpoint_thread.joinable()) {
+        if (checkpointing.load()) std::cout << "Waiting for the checkpoint to finish...\n";
+        checkpoint_thread.join();
+    }
     screens->shutdown();
     delete screens; // Clean up
     std::cout << "Exiting program.\n";
@@ -178,20 +441,17 @@ void mainThread() {
             Exit();
         }
         else if (firstInput == "initialize") {
+            if (initialized.load()) {
+                std::cout << "Already initialized. Use \"reconfigure\" to apply changes from " << CONFIG_FILE << ".\n";
+                continue;
+            }
     
             try {
             
-                config->loadConfig("config.txt"); // Load configuration file
+                config->loadConfig(CONFIG_FILE); // Load configuration file
              
                 // Print out config values
-                std::cout << "Configuration values:\n";
-                std::cout << "  num-cpu: " << config->getNumCPU() << "\n";
-                std::cout << "  scheduler: " << config->getSchedulerType() << "\n";
-                std::cout << "  quantum-cycles: " << config->getQuantumCycles() << "\n";
-                std::cout << "  batch-process-freq: " << config->getBatchProcessFreq() << "\n";
-                std::cout << "  min-ins: " << config->getMinIns() << "\n";
-                std::cout << "  max-ins: " << config->getMaxIns() << "\n";
-                std::cout << "  delay-per-exec: " << config->getDelayPerExec() << "\n";
+                printConfig(config->snapshot());
 
                 if (config->isInitialized()) {
                     initialized.store(true);
@@ -216,11 +476,53 @@ void mainThread() {
                 Screen(inputBuffer);
             }
             else if (firstInput == "scheduler-start") {
-                SchedulerStart(config->getBatchProcessFreq(), config->getMinIns(), config->getMaxIns());
+                SchedulerStart();
             }
             else if (firstInput == "scheduler-stop") {
                 SchedulerStop();
             }
+            else if (firstInput == "reconfigure") {
+                if (inputBuffer.size() == 1) {
+                    Reconfigure();
+                }
+                else if (inputBuffer[1] == "watch" && !watching_config.load()) {
+                    WatchConfig();
+                }
+                else if (inputBuffer[1] == "watch") {
+                    std::cout << "Already watching " << CONFIG_FILE << ".\n";
+                }
+                else if (inputBuffer[1] == "unwatch") {
+                    UnwatchConfig();
+                    std::cout << "Stopped watching " << CONFIG_FILE << ".\n";
+                }
+                else {
+                    std::cout << "Usage: reconfigure [watch | unwatch]\n";
+                }
+            }
+            else if (firstInput == "replay") {
+                if (inputBuffer.size() == 2) {
+                    Replay(inputBuffer[1]);
+                }
+                else {
+                    std::cout << "Usage: replay <trace-file>\n";
+                }
+            }
+            else if (firstInput == "checkpoint") {
+                if (inputBuffer.size() == 2) {
+                    Checkpoint(inputBuffer[1]);
+                }
+                else {
+                    std::cout << "Usage: checkpoint <file>\n";
+                }
+            }
+            else if (firstInput == "restore") {
+                if (inputBuffer.size() == 2) {
+                    Restore(inputBuffer[1]);
+                }
+                else {
+                    std::cout << "Usage: restore <file>\n";
+                }
+            }
             else if (firstInput == "clear") {
                 Clear();
             }
@@ -0,0 +1,255 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <new>
+
+/* generated processes are called Process_<pid> */
+inline std::string generatedName(int pid) {
+    return "Process_" + std::to_string(pid);
+}
+
+/* pid encoded in a canonical Process_<pid> name, or -1 for any other name */
+inline int generatedPid(const char* s, size_t n) {
+    static const char prefix[] = "Process_";
+    const size_t plen = sizeof(prefix) - 1;
+    if (n <= plen || n > plen + 10 || memcmp(s, prefix, plen) != 0) return -1;
+    if (s[plen] == '0' && n > plen + 1) return -1;    // "Process_007" is not canonical
+
+    int64_t pid = 0;
+    for (size_t i = plen; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        pid = pid * 10 + (s[i] - '0');
+    }
+    return pid <= INT32_MAX ? (int)pid : -1;
+}
+
+inline int generatedPid(const std::string& name) {
+    return generatedPid(name.data(), name.size());
+}
+
+/*
+ * name -> pid index built for millions of processes.
+ *
+ *  - Generated names never reach the hash table: a bit per pid says
+ *    "Process_<pid> exists", and lookups parse the number back out.
+ *  - Other names are interned once in an append-only arena; the table
+ *    itself only holds 16-byte slots (hash, pid, pointer to the key).
+ *  - Growing the table never rehashes everything at once. A bigger table
+ *    is allocated and every insert moves a few slots of the old one over,
+ *    while lookups check both. The copy finishes well before the new
+ *    table can fill up, so no single insert pays for a full rehash.
+ *
+ * Not thread-safe; ProcessTable serializes access.
+ */
+class NameIndex {
+private:
+    struct Slot {
+        uint32_t    hash;
+        int32_t     pid;
+        const char* key;    // interned: uint32_t length, then the bytes; nullptr = empty
+    };
+
+    struct FreeSlots {
+        void operator()(Slot* p) const { free(p); }
+    };
+
+    struct Table {
+        std::unique_ptr<Slot[], FreeSlots> slots;
+        size_t mask = 0;
+        size_t used = 0;
+
+        size_t capacity() const { return slots ? mask + 1 : 0; }
+    };
+
+    static const size_t INITIAL_CAPACITY = 64;
+    static const size_t MIGRATE_STEP = 8;
+    static const size_t ARENA_BLOCK = 64 * 1024;
+    static const int    BIT_BLOCK_BITS = 16;    // 65536 pids per bitmap block
+
+    Table  cur;
+    Table  old;             // still being drained into <cur> after a grow
+    size_t migrated = 0;    // old slots already handled
+
+    std::vector<std::unique_ptr<char[]>> arena;
+    std::vector<std::unique_ptr<char[]>> oversized;   // names longer than a block
+    size_t arena_used = ARENA_BLOCK;
+
+    std::vector<std::unique_ptr<uint64_t[]>> generated;
+    size_t count = 0;
+
+    static uint32_t hashOf(const char* s, size_t n) {
+        uint64_t h = 1469598103934665603ull;    // FNV-1a
+        for (size_t i = 0; i < n; i++) {
+            h ^= (unsigned char)s[i];
+            h *= 1099511628211ull;
+        }
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    static bool keyEquals(const char* key, const char* s, size_t n) {
+        uint32_t len;
+        memcpy(&len, key, sizeof(len));
+        return len == n && memcmp(key + sizeof(len), s, n) == 0;
+    }
+
+    const char* intern(const char* s, size_t n) {
+        size_t need = sizeof(uint32_t) + n;
+        char* dst;
+        if (need > ARENA_BLOCK) {
+            oversized.push_back(std::unique_ptr<char[]>(new char[need]));
+            dst = oversized.back().get();
+        }
+        else {
+            if (arena_used + need > ARENA_BLOCK) {
+                arena.push_back(std::unique_ptr<char[]>(new char[ARENA_BLOCK]));
+                arena_used = 0;
+            }
+            dst = arena.back().get() + arena_used;
+            arena_used += need;
+        }
+        uint32_t len = (uint32_t)n;
+        memcpy(dst, &len, sizeof(len));
+        memcpy(dst + sizeof(len), s, n);
+        return dst;
+    }
+
+    static Slot* probe(const Table& t, uint32_t h, const char* s, size_t n) {
+        if (!t.slots) return nullptr;
+        for (size_t i = h & t.mask;; i = (i + 1) & t.mask) {
+            Slot& slot = t.slots[i];
+            if (slot.key == nullptr) return nullptr;
+            if (slot.hash == h && keyEquals(slot.key, s, n)) return &slot;
+        }
+    }
+
+    static Slot* probeKey(const Table& t, uint32_t h, const char* key) {
+        uint32_t len;
+        memcpy(&len, key, sizeof(len));
+        return probe(t, h, key + sizeof(len), len);
+    }
+
+    static void place(Table& t, const Slot& entry) {
+        size_t i = entry.hash & t.mask;
+        while (t.slots[i].key != nullptr) i = (i + 1) & t.mask;
+        t.slots[i] = entry;
+        t.used++;
+    }
+
+    /* calloc: large tables come back as untouched zero pages, so growing costs nothing up front */
+    static void allocate(Table& t, size_t capacity) {
+        Slot* slots = static_cast<Slot*>(calloc(capacity, sizeof(Slot)));
+        if (!slots) throw std::bad_alloc();
+        t.slots.reset(slots);
+        t.mask = capacity - 1;
+        t.used = 0;
+    }
+
+    /* move up to <budget> old slots; entries already re-inserted into <cur> win */
+    void migrate(size_t budget) {
+        while (old.slots && budget-- > 0) {
+            const Slot& slot = old.slots[migrated++];
+            if (slot.key != nullptr && !probeKey(cur, slot.hash, slot.key)) {
+                place(cur, slot);
+            }
+            if (migrated > old.mask) {
+                old.slots.reset();
+                old.used = 0;
+            }
+        }
+    }
+
+    void grow() {
+        migrate(SIZE_MAX);                      // only if a previous grow somehow hasn't finished
+        size_t capacity = cur.capacity() ? cur.capacity() * 2 : INITIAL_CAPACITY;
+        old = std::move(cur);
+        cur = Table();
+        allocate(cur, capacity);
+        migrated = 0;
+    }
+
+public:
+    NameIndex() {
+        allocate(cur, INITIAL_CAPACITY);
+    }
+
+    size_t size() const { return count; }
+
+    void addGenerated(int pid) {
+        size_t block = (size_t)pid >> BIT_BLOCK_BITS;
+        while (generated.size() <= block) {
+            size_t words = ((size_t)1 << BIT_BLOCK_BITS) / 64;
+            generated.push_back(std::unique_ptr<uint64_t[]>(new uint64_t[words]()));
+        }
+        size_t bit = (size_t)pid & (((size_t)1 << BIT_BLOCK_BITS) - 1);
+        uint64_t& word = generated[block][bit / 64];
+        if (!(word & (1ull << (bit % 64)))) {
+            word |= 1ull << (bit % 64);
+            count++;
+        }
+    }
+
+    bool hasGenerated(int pid) const {
+        if (pid < 0) return false;
+        size_t block = (size_t)pid >> BIT_BLOCK_BITS;
+        if (block >= generated.size()) return false;
+        size_t bit = (size_t)pid & (((size_t)1 << BIT_BLOCK_BITS) - 1);
+        return (generated[block][bit / 64] >> (bit % 64)) & 1;
+    }
+
+    /* map <name> to <pid>, replacing any previous mapping of the same name */
+    void add(const std::string& name, int pid) {
+        if (generatedPid(name) == pid) {
+            addGenerated(pid);
+            return;
+        }
+
+        migrate(MIGRATE_STEP);
+
+        uint32_t h = hashOf(name.data(), name.size());
+        Slot* hit = probe(cur, h, name.data(), name.size());
+        if (hit) {
+            hit->pid = pid;
+            return;
+        }
+
+        Slot* stale = old.slots ? probe(old, h, name.data(), name.size()) : nullptr;
+
+        if ((cur.used + 1) * 4 > cur.capacity() * 3) {
+            grow();
+            if (stale) stale = probe(old, h, name.data(), name.size());
+        }
+
+        Slot entry;
+        entry.hash = h;
+        entry.pid = pid;
+        entry.key = stale ? stale->key : intern(name.data(), name.size());
+        place(cur, entry);
+        if (!stale) count++;
+    }
+
+    /* pid registered under <name>, or -1 */
+    int find(const std::string& name) const {
+        int pid = generatedPid(name);
+        if (pid >= 0 && hasGenerated(pid)) return pid;
+
+        uint32_t h = hashOf(name.data(), name.size());
+        const Slot* hit = probe(cur, h, name.data(), name.size());
+        if (!hit && old.slots) hit = probe(old, h, name.data(), name.size());
+        return hit ? hit->pid : -1;
+    }
+
+    void clear() {
+        allocate(cur, INITIAL_CAPACITY);
+        old = Table();
+        migrated = 0;
+        arena.clear();
+        oversized.clear();
+        arena_used = ARENA_BLOCK;
+        generated.clear();
+        count = 0;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+ * Stop-the-world point for a fixed set of worker threads.
+ *
+ * Each worker wraps one unit of work (an instruction, a clock tick, a
+ * balancer pass) in enter(i) / leave(i); waiting on the clock happens
+ * outside. pause() returns once no worker is inside a unit and keeps them
+ * out until resume(), so whoever paused sees a consistent scheduler.
+ *
+ * Workers only touch their own flag on the fast path: the flags sit on
+ * separate cache lines and the shared <pausing> flag is only read.
+ */
+class PauseGate {
+private:
+    struct Slot {
+        std::atomic<bool> busy{ false };
+        char pad[64 - sizeof(std::atomic<bool>)];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    int workers;
+    std::atomic<bool> pausing{ false };
+    std::mutex pauser_mx;               // held from pause() to resume()
+    std::mutex gate_mx;
+    std::condition_variable gate_cv;
+
+public:
+    explicit PauseGate(int workers) : slots(new Slot[workers]), workers(workers) {}
+
+    PauseGate(const PauseGate&) = delete;
+    PauseGate& operator=(const PauseGate&) = delete;
+
+    void enter(int i) {
+        for (;;) {
+            slots[i].busy.store(true);          // seq_cst: pairs with pause()
+            if (!pausing.load()) return;
+            slots[i].busy.store(false);
+
+            std::unique_lock<std::mutex> lock(gate_mx);
+            gate_cv.wait(lock, [&] { return !pausing.load(); });
+        }
+    }
+
+    void leave(int i) {
+        slots[i].busy.store(false, std::memory_order_release);
+    }
+
+    /* a second pauser waits until the first one resumes */
+    void pause() {
+        pauser_mx.lock();
+        pausing.store(true);
+        for (int i = 0; i < workers; i++) {
+            while (slots[i].busy.load()) std::this_thread::yield();
+        }
+    }
+
+    void resume() {
+        {
+            std::lock_guard<std::mutex> lock(gate_mx);
+            pausing.store(false);
+        }
+        gate_cv.notify_all();
+        pauser_mx.unlock();
+    }
+
+    /* enter / leave for one scope */
+    class Hold {
+    private:
+        PauseGate& gate;
+        int i;
+    public:
+        Hold(PauseGate& gate, int i) : gate(gate), i(i) { gate.enter(i); }
+        ~Hold() { gate.leave(i); }
+    };
+};
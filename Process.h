@@ -6,6 +6,11 @@
 #include <time.h>
 #include <vector>     // ADDED
 #include <mutex>      // ADDED
+#include <atomic>
+#include <cstring>
+#include "TimerWheel.h"
+#include "Rng.h"
+#include "NameIndex.h"
 
 using namespace std;
 
@@ -16,13 +21,30 @@ enum Status {
     TERMINATED
 };
 
+enum InstructionType {
+    PRINT,
+    SLEEP,      // voluntary sleep, short
+    IO_WAIT     // blocked on simulated I/O, longer
+};
+
+/* odds (in percent) and length range (in ticks) of blocking instructions */
+const int SLEEP_CHANCE   = 2;
+const int SLEEP_MIN      = 10;
+const int SLEEP_MAX      = 100;
+const int IO_WAIT_CHANCE = 1;
+const int IO_WAIT_MIN    = 200;
+const int IO_WAIT_MAX    = 1000;
+
 class ScreenFactory {
 private:
-    string name;
+    string name;           //  empty for generated Process_<pid> names
+    int    pid;
     string timeCreated;
     int    lineOfInstruction;
     int    totalLineofInstruction;
     Status status;
+    Rng    rng;            //  private stream, derived from (run seed, pid)
+    atomic<int> lastCore;  //  core it last ran on, -1 = never ran
 
     /* ----------------------- NEW ----------------------- */
     vector<string> logs;   //  keeps all PRINT-generated lines
@@ -30,8 +52,17 @@ private:
     /* --------------------------------------------------- */
 
 public:
-    ScreenFactory(string name, int min_ins, int max_ins) {
-        this->name = name;
+    TimerNode timer;       //  armed while the process is WAITING
+
+    /* an empty <name> gives the process its generated name, Process_<pid> */
+    ScreenFactory(string name, int pid, int min_ins, int max_ins, uint64_t seed) {
+        if (generatedPid(name) != pid) {
+            this->name = name;   // only custom names are stored
+        }
+        this->pid = pid;
+        this->lastCore = -1;
+        this->rng = Rng::stream(seed, pid);
+        this->timer.owner = this;
         this->lineOfInstruction = 0;
         setTotalLineofInstruction(min_ins, max_ins);
         this->status = READY;
@@ -39,21 +70,99 @@ public:
         /*  ⬆  no more file creation / “output” folder */
     }
 
+    /* a process read back from a checkpoint; its logs follow through restoreLogs */
+    ScreenFactory(int pid, string name, string timeCreated, int line, int total, Status status, uint64_t rng_state, int last_core) {
+        if (generatedPid(name) != pid) {
+            this->name = name;
+        }
+        this->pid = pid;
+        this->lastCore = last_core;
+        this->rng = Rng::fromState(rng_state);
+        this->timer.owner = this;
+        this->timeCreated = timeCreated;
+        this->lineOfInstruction = line;
+        this->totalLineofInstruction = total;
+        this->status = status;
+    }
+
     /* simple accessors */
     string getTime() { return timeCreated; }
-    string getName() { return name; }
+    string getName() { return name.empty() ? generatedName(pid) : name; }
+    bool   hasGeneratedName() const { return name.empty(); }
+    int    getPid() const { return pid; }
     Status getStatus()        const { return status; }
     int    getLineOfInstruction() { return lineOfInstruction; }
     int    getTotalLineofInstruction() { return totalLineofInstruction; }
     void   setStatus(Status s) { status = s; }
+    int    getLastCore() const { return lastCore; }
+    void   setLastCore(int core) { lastCore = core; }
+    uint64_t getRngState() const { return rng.getState(); }
 
     /* NEW – used by process-smi */
-    vector<string> getLogsCopy() {
+    size_t getLogCount() {
+        lock_guard<mutex> g(log_mx);
+        return logs.size();
+    }
+
+    /*
+     * appends log lines [from, to) to <out>, one per line, and returns the
+     * index after the last one copied; callers page through long logs so the
+     * writing core never waits on more than one page
+     */
+    size_t appendLogs(size_t from, size_t to, string& out) {
         lock_guard<mutex> g(log_mx);
-        return logs;          // copy is fine for read-only printing
+        if (to > logs.size()) to = logs.size();
+        for (size_t i = from; i < to; i++) {
+            out += logs[i];
+            out += '\n';
+        }
+        return from < to ? to : from;
+    }
+
+    /* <bytes> of '\n'-terminated lines, as written by a checkpoint */
+    void restoreLogs(const char* text, size_t bytes, size_t lines) {
+        lock_guard<mutex> g(log_mx);
+        logs.reserve(logs.size() + lines);
+        const char* end = text + bytes;
+        while (text < end) {
+            const char* eol = static_cast<const char*>(memchr(text, '\n', end - text));
+            if (!eol) eol = end;
+            logs.emplace_back(text, eol - text);
+            text = eol + 1;
+        }
+    }
+
+    /*
+     * called by a core thread – runs the next instruction and returns how
+     * many ticks the process must now block for (0 = keep running)
+     */
+    int execute(int core) {
+        if (status != RUNNING || lineOfInstruction >= totalLineofInstruction) {
+            return 0;
+        }
+
+        int ticks = 0;
+        switch (nextInstruction()) {
+        case SLEEP:
+            ticks = rng.range(SLEEP_MIN, SLEEP_MAX);
+            lineOfInstruction += 1;
+            break;
+        case IO_WAIT:
+            ticks = rng.range(IO_WAIT_MIN, IO_WAIT_MAX);
+            lineOfInstruction += 1;
+            break;
+        default:
+            print(core);
+            break;
+        }
+
+        if (lineOfInstruction >= totalLineofInstruction) {
+            status = TERMINATED;
+            return 0;
+        }
+        return ticks;
     }
 
-    /* called by a core thread */
     void print(int core) {
         if (status == RUNNING) {
             if (lineOfInstruction < totalLineofInstruction) {
@@ -68,7 +177,7 @@ public:
                 /* build log line */
                 string entry =
                     string(stamp) + " Core:" + to_string(core) +
-                    " \"Hello world from " + name + "!\"";
+                    " \"Hello world from " + getName() + "!\"";
 
                 /* store it thread-safely */
                 {
@@ -85,11 +194,17 @@ public:
     }
 
     void setTotalLineofInstruction(int min_ins, int max_ins) {
-        int range = max_ins - min_ins + 1;
-        totalLineofInstruction = rand() % range + min_ins;
+        totalLineofInstruction = rng.range(min_ins, max_ins);
     }
 
 private:
+    InstructionType nextInstruction() {
+        int roll = rng.range(0, 99);
+        if (roll < SLEEP_CHANCE) return SLEEP;
+        if (roll < SLEEP_CHANCE + IO_WAIT_CHANCE) return IO_WAIT;
+        return PRINT;
+    }
+
     void initializeTimeCreated() {
         time_t now = time(0);
         tm localTime;
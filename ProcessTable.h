@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Process.h"
+#include "NameIndex.h"
+
+/*
+ * Every process, addressed by pid.
+ *
+ * Pids index straight into fixed-size chunks that are never moved once
+ * allocated, so get(pid) is lock-free and adding a process never copies
+ * the table. Name lookups go through a NameIndex behind a short lock.
+ */
+class ProcessTable {
+private:
+    static const int CHUNK_BITS = 16;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static const int MAX_CHUNKS = 1 << (31 - CHUNK_BITS);
+
+    std::unique_ptr<std::atomic<ScreenFactory*>*[]> chunks;
+    std::atomic<int> chunk_count{ 0 };
+    std::atomic<int> pid_limit{ 0 };    // one past the highest pid seen
+    std::atomic<size_t> count{ 0 };
+
+    NameIndex names;
+    std::mutex table_mx;                // guards <names> and chunk allocation
+
+public:
+    ProcessTable() : chunks(new std::atomic<ScreenFactory*>*[MAX_CHUNKS]()) {}
+
+    ~ProcessTable() {
+        for (int c = 0; c < chunk_count; c++) {
+            delete[] chunks[c];
+        }
+    }
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    void insert(ScreenFactory* screen) {
+        int pid = screen->getPid();
+        std::lock_guard<std::mutex> g(table_mx);
+
+        int chunk = pid >> CHUNK_BITS;
+        while (chunk_count <= chunk) {
+            std::atomic<ScreenFactory*>* fresh = new std::atomic<ScreenFactory*>[CHUNK_SIZE];
+            for (int i = 0; i < CHUNK_SIZE; i++) fresh[i].store(nullptr, std::memory_order_relaxed);
+            chunks[chunk_count] = fresh;
+            chunk_count.fetch_add(1, std::memory_order_release);
+        }
+
+        if (chunks[chunk][pid & (CHUNK_SIZE - 1)].exchange(screen, std::memory_order_release) == nullptr) {
+            count++;
+        }
+        if (pid >= pid_limit) pid_limit = pid + 1;
+
+        if (screen->hasGeneratedName()) {
+            names.addGenerated(pid);
+        }
+        else {
+            names.add(screen->getName(), pid);
+        }
+    }
+
+    ScreenFactory* get(int pid) const {
+        if (pid < 0 || (pid >> CHUNK_BITS) >= chunk_count.load(std::memory_order_acquire)) return nullptr;
+        return chunks[pid >> CHUNK_BITS][pid & (CHUNK_SIZE - 1)].load(std::memory_order_acquire);
+    }
+
+    ScreenFactory* find(const std::string& name) {
+        int pid;
+        {
+            std::lock_guard<std::mutex> g(table_mx);
+            pid = names.find(name);
+        }
+        return get(pid);
+    }
+
+    size_t size() const { return count; }
+    int limit() const { return pid_limit; }
+
+    /* visit every process in pid order */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        int end = limit();
+        for (int pid = 0; pid < end; pid++) {
+            ScreenFactory* screen = get(pid);
+            if (screen) fn(screen);
+        }
+    }
+};
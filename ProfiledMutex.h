@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/*
+ * std::mutex that counts how often it was taken and how often the taker
+ * found it already held. Works with lock_guard, unique_lock and std::lock.
+ *
+ * An uncontended lock costs one extra relaxed increment on a cache line
+ * the mutex already owns, so the scheduler keeps it on permanently and
+ * SchedulerBench reads the counters.
+ */
+class ProfiledMutex {
+private:
+    std::mutex mx;
+    std::atomic<uint64_t> acquired{ 0 };
+    std::atomic<uint64_t> contended{ 0 };
+
+public:
+    void lock() {
+        if (!mx.try_lock()) {
+            contended.fetch_add(1, std::memory_order_relaxed);
+            mx.lock();
+        }
+        acquired.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool try_lock() {
+        if (!mx.try_lock()) return false;
+        acquired.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void unlock() { mx.unlock(); }
+
+    uint64_t acquisitions() const { return acquired.load(std::memory_order_relaxed); }
+    uint64_t contentions() const { return contended.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+/*
+ * Small, fast PRNG (xorshift64*) with 8 bytes of state, so every process
+ * can own an independent stream instead of sharing rand()'s global state.
+ * Streams are derived from (run seed, stream id) with splitmix64, which
+ * makes a run fully reproducible from the seed in config.txt.
+ */
+class Rng {
+private:
+    uint64_t state;
+
+    static uint64_t splitmix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+public:
+    explicit Rng(uint64_t seed = 0) {
+        state = splitmix64(seed);
+        if (state == 0) state = 0x2545F4914F6CDD1Dull;   // xorshift must not start at 0
+    }
+
+    /* independent stream <id> of run <seed> */
+    static Rng stream(uint64_t seed, uint64_t id) {
+        return Rng(splitmix64(seed) ^ splitmix64(~id));
+    }
+
+    /* raw state, for checkpoints */
+    uint64_t getState() const { return state; }
+    static Rng fromState(uint64_t state) {
+        Rng r;
+        r.state = state ? state : 0x2545F4914F6CDD1Dull;
+        return r;
+    }
+
+    uint32_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    /* uniform in [lo, hi] */
+    uint32_t range(uint32_t lo, uint32_t hi) {
+        uint64_t span = (uint64_t)hi - lo + 1;
+        return lo + (uint32_t)(((uint64_t)next() * span) >> 32);
+    }
+};
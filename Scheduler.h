@@ -2,55 +2,160 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <mutex>
 #include <atomic>
-#include <queue> 
+#include <deque> 
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <conio.h>
 #include "Process.h"
+#include "ProcessTable.h"
+#include "TimerWheel.h"
+#include "EventTrace.h"
+#include "ProfiledMutex.h"
+#include "PauseGate.h"
+#include "Checkpoint.h"
 #include <thread>
 #include <Windows.h>
 #include <fstream>    
 
+// Counters read by SchedulerBench; taken while the scheduler keeps running
+struct SchedulerStats {
+	uint64_t cycles;
+	uint64_t instructions;          // executed so far, over all processes
+	uint64_t finished;
+	uint64_t dispatches;
+	uint64_t dispatch_wait_total;   // ticks spent queued before a dispatch
+	uint64_t dispatch_wait_max;
+	uint64_t migrations;
+	uint64_t lock_acquisitions;     // running, waiting and per-core queue locks
+	uint64_t lock_contended;
+};
+
 class ScreenManager {
 
 	private: 
-		unordered_map<string, ScreenFactory*> screens;
-
-		queue<ScreenFactory*> ready_queue;
-
-		std::vector <string> running_queue;
+		ProcessTable screens;
+
+		// One ready queue per core. Processes go back to the core they last
+		// ran on; the balancer only moves work when loads drift too far apart.
+		struct Ready {
+			ScreenFactory* screen;
+			uint64_t since;            // tick it was queued
+		};
+		struct CoreQueue {
+			ProfiledMutex mx;
+			std::deque<Ready> q;
+			std::atomic<int> depth{ 0 };
+
+			// dispatch latency, updated under <mx>
+			uint64_t dispatches = 0;
+			uint64_t wait_total = 0;
+			uint64_t wait_max = 0;
+		};
+		std::vector<std::unique_ptr<CoreQueue>> core_queues;
+		std::atomic<uint64_t> migrations{ 0 };
+
+		static const int BALANCE_INTERVAL = 5;       // ticks between balancer passes
+		static const int IMBALANCE_THRESHOLD = 2;    // min load difference that triggers a migration
+
+		std::vector <ScreenFactory*> running_queue;   // process on each core, nullptr = idle
+
+		// Instructions the current rr process has run in its slice, one cache line per core
+		struct SliceCounter {
+			uint32_t used = 0;
+			char pad[64 - sizeof(uint32_t)];
+		};
+		std::vector<SliceCounter> slice_used;
 		std::vector <thread> core_threads;
 		int cores;
 		bool insideScreen;
 
 		atomic<bool> running = true;
 
-		int cpu_cycles = 0;
+		// Simulation clock, one tick per millisecond
+		std::atomic<uint64_t> cpu_cycles{ 0 };
+		std::condition_variable clock_cv;
+
+		// Lockstep mode (benchmarks): instead of sleeping 1 ms, the clock ticks as
+		// soon as every core is waiting on a later tick. core_target[i] is the tick
+		// core i waits for, 0 while it is working; both guarded by clock_mutex.
+		std::atomic<bool> lockstep{ false };
+		std::vector<uint64_t> core_target;
+		std::condition_variable tick_cv;
+
+		// Processes blocked on SLEEP / IO_WAIT, keyed on their wake-up tick
+		TimerWheel waiting;
 
 		// MUTEX LOCKS
-		std::mutex screens_mutex;
-		std::mutex ready_queue_mutex;
-		std::mutex running_queue_mutex; 
+		ProfiledMutex running_queue_mutex; 
+		ProfiledMutex waiting_mutex;
+		std::mutex clock_mutex;         // plain: clock_cv waits on it
 
 		int count = 0;
-		int delay = 0;
-		int timeslice = 0;
+		int RR = 0;
+
+		// Quantum (high 32 bits) and delay-per-exec (low 32 bits) share one
+		// atomic, so cores never see a reconfigure half-applied
+		std::atomic<uint64_t> sched_params{ 0 };
+
+		static uint64_t packParams(uint32_t timeslice, uint32_t delay) {
+			return ((uint64_t)timeslice << 32) | delay;
+		}
+		static uint32_t paramTimeslice(uint64_t p) { return (uint32_t)(p >> 32); }
+		static uint32_t paramDelay(uint64_t p) { return (uint32_t)(p & 0xFFFFFFFF); }
+
+		// Run seed; every process draws from its own stream derived from it
+		uint64_t seed = 0;
+		std::atomic<int> next_pid{ 0 };
+
+		// Trace producers: core i records into ring i, plus one ring each for
+		// the manager and clock threads; everyone else uses the shared ring
+		EventTrace trace;
+		int managerRing() const { return cores; }
+		int clockRing() const { return cores + 1; }
+
+		// Cores, balancer and clock step through here; checkpoint and restore
+		// pause them all (same numbering as the trace rings)
+		PauseGate gate;
 
 	public:
 		void shutdown() {
-			running = false;
+			{
+				std::lock_guard<std::mutex> lock(clock_mutex);
+				running = false;
+			}
+			tick_cv.notify_all();
+			trace.close();
 		}
 
-		ScreenManager(int cores, int delay, int timeslice, int RR) : cores(cores), insideScreen(false) {
-			this->delay = delay;
-			this->timeslice = timeslice;
+		// Tick as fast as the cores finish their work instead of once per millisecond
+		void setLockstepClock(bool on) {
+			{
+				std::lock_guard<std::mutex> lock(clock_mutex);
+				lockstep = on;
+			}
+			tick_cv.notify_all();
+		}
+
+		ScreenManager(int cores, int delay, int timeslice, int RR, uint64_t seed) : slice_used(cores), cores(cores), insideScreen(false), gate(cores + 2) {
+			this->sched_params = packParams(timeslice, delay);
+			this->RR = RR;
+			this->seed = seed;
+			core_target.assign(cores, 0);
 
 			for (int i = 0; i < cores; i++) {
-				running_queue.push_back("");
+				running_queue.push_back(nullptr);
+				core_queues.push_back(std::unique_ptr<CoreQueue>(new CoreQueue()));
 			}
 
 			std::thread manager(&ScreenManager::managerJob, this);
-			manager.detach(); // Detach the manager thread to let it run independently
+			manager.detach(); // Detach the balancer thread to let it run independently
+
+			std::thread clock(&ScreenManager::clockJob, this);
+			clock.detach();
 
 			/*--- Initialize Cores ---*/
 			for (int i = 0; i < cores; i++) {
@@ -64,21 +169,272 @@ class ScreenManager {
 			}
 		}
 
-		void addScreen(string name, int min_ins, int max_ins) {
-			ScreenFactory* screen = new ScreenFactory(name, min_ins, max_ins);
+		// Returns -1 for a Process_<n> name unless <n> is exactly the pid it would get:
+		// lookups trust the generated-name bitmap, so such a name would later be shadowed
+		int addScreen(string name, int min_ins, int max_ins) {
+			int pid;
+			int reserved = generatedPid(name);
+			if (reserved >= 0) {
+				int expected = reserved;
+				if (!next_pid.compare_exchange_strong(expected, reserved + 1)) return -1;
+				pid = reserved;
+			}
+			else {
+				pid = next_pid++;
+			}
+			admit(new ScreenFactory(name, pid, min_ins, max_ins, seed));
+			return pid;
+		}
+
+		// Generated processes are named after their pid
+		int addProcess(int min_ins, int max_ins) {
+			int pid = next_pid++;
+			admit(new ScreenFactory("", pid, min_ins, max_ins, seed));
+			return pid;
+		}
+
+		// Re-create a process from a trace: same pid, length and RNG stream
+		void addReplayed(int pid, int total_ins, uint64_t trace_seed) {
+			int expected = next_pid.load();
+			while (expected <= pid && !next_pid.compare_exchange_weak(expected, pid + 1)) {}
+			admit(new ScreenFactory("", pid, total_ins, total_ins, trace_seed));
+		}
+
+		// Picked up by every core on its next instruction; running processes,
+		// queues and core threads are left untouched
+		void reconfigure(uint32_t timeslice, uint32_t delay) {
+			sched_params = packParams(timeslice, delay);
+		}
+
+		size_t processCount() {
+			return screens.size();
+		}
+
+		uint64_t getCycle() const { return cpu_cycles; }
+
+		// Clock and instruction counts are read in one pause so they describe the same tick
+		SchedulerStats stats() {
+			SchedulerStats st = {};
+			gate.pause();
+			st.cycles = cpu_cycles;
+			st.migrations = migrations;
+
+			screens.forEach([&](ScreenFactory* screen) {
+				st.instructions += screen->getLineOfInstruction();
+				if (screen->getStatus() == TERMINATED) st.finished++;
+			});
+			gate.resume();
+
+			for (int i = 0; i < cores; i++) {
+				CoreQueue& cq = *core_queues[i];
+				{
+					std::lock_guard<ProfiledMutex> lock(cq.mx);
+					st.dispatches += cq.dispatches;
+					st.dispatch_wait_total += cq.wait_total;
+					if (cq.wait_max > st.dispatch_wait_max) st.dispatch_wait_max = cq.wait_max;
+				}
+				st.lock_acquisitions += cq.mx.acquisitions();
+				st.lock_contended += cq.mx.contentions();
+			}
+			st.lock_acquisitions += running_queue_mutex.acquisitions() + waiting_mutex.acquisitions();
+			st.lock_contended += running_queue_mutex.contentions() + waiting_mutex.contentions();
+			return st;
+		}
+
+		// Everything but the logs, copied while cores, balancer and clock are parked;
+		// writeCheckpoint streams the logs afterwards
+		void captureCheckpoint(CheckpointImage& image) {
+			gate.pause();
+
+			CheckpointHeader& h = image.header;
+			h.magic = CHECKPOINT_MAGIC;
+			h.version = CHECKPOINT_VERSION;
+			h.cores = (uint16_t)cores;
+			h.scheduler = (uint8_t)RR;
+			h.quantum = paramTimeslice(sched_params);
+			h.delay = paramDelay(sched_params);
+			h.seed = seed;
+			h.cycle = cpu_cycles;
+			h.next_pid = next_pid;
+			h.migrations = migrations;
+
+			for (int i = 0; i < cores; i++) {
+				CheckpointCore c = {};
+				ScreenFactory* screen = current(i);
+				c.running = screen ? screen->getPid() : -1;
+				c.slice_used = slice_used[i].used;
+
+				CoreQueue& cq = *core_queues[i];
+				std::lock_guard<ProfiledMutex> lock(cq.mx);
+				c.queued = (uint32_t)cq.q.size();
+				for (const Ready& r : cq.q) {
+					CheckpointQueued q = { r.screen->getPid(), r.since };
+					image.queued.push_back(q);
+				}
+				image.cores.push_back(c);
+			}
+			h.queued = image.queued.size();
+
+			{
+				std::lock_guard<ProfiledMutex> lock(waiting_mutex);
+				screens.forEach([&](ScreenFactory* screen) {
+					CheckpointProcess p = {};
+					p.pid = screen->getPid();
+					p.line = screen->getLineOfInstruction();
+					p.total = screen->getTotalLineofInstruction();
+					p.status = (uint8_t)screen->getStatus();
+					p.last_core = (int16_t)screen->getLastCore();
+					p.rng = screen->getRngState();
+					p.wake_at = screen->timer.armed() ? screen->timer.expires : 0;
+					p.log_lines = (uint32_t)screen->getLogCount();
+
+					image.names.push_back(screen->hasGeneratedName() ? string() : screen->getName());
+					image.created.push_back(screen->getTime());
+					p.name_len = (uint32_t)image.names.back().size();
+					p.created_len = (uint32_t)image.created.back().size();
+
+					image.processes.push_back(p);
+					image.screens.push_back(screen);
+				});
+			}
+			h.processes = (uint32_t)image.processes.size();
+
+			gate.resume();
+		}
+
+		// Load a checkpoint into this (empty) manager and adopt its seed. Times are
+		// shifted so the clock only moves forward; returns the number of processes restored.
+		size_t restore(const CheckpointFile& ck) {
+			const CheckpointHeader& h = ck.header();
+
+			// Rebuilding processes and their logs is the slow part; do it in parallel before pausing
+			std::vector<ScreenFactory*> restored(h.processes, nullptr);
+			std::atomic<bool> out_of_memory{ false };
+			unsigned workers = std::max<unsigned>(1, std::min<unsigned>(std::thread::hardware_concurrency(), 16));
+			std::vector<std::thread> builders;
+			for (unsigned w = 0; w < workers; w++) {
+				builders.push_back(std::thread([&, w]() {
+					try {
+						for (uint32_t i = w; i < h.processes && !out_of_memory; i += workers) {
+							CheckpointProcess p = ck.process(i);
+							const char* text = ck.text(p);
+							string name(text, p.name_len);
+							string created(text + p.name_len, p.created_len);
+							restored[i] = new ScreenFactory(p.pid, name, created, p.line, p.total,
+								(Status)p.status, p.rng, p.last_core < cores ? p.last_core : -1);
+							restored[i]->restoreLogs(text + p.name_len + p.created_len, (size_t)p.log_bytes, p.log_lines);
+						}
+					}
+					catch (const std::bad_alloc&) {
+						out_of_memory = true;
+					}
+				}));
+			}
+			for (std::thread& t : builders) t.join();
+
+			// Every pid is below next_pid (CheckpointFile checked), so this is the last large allocation
+			std::vector<char> placed;
+			if (!out_of_memory) {
+				try {
+					placed.assign(h.next_pid, 0);
+				}
+				catch (const std::bad_alloc&) {
+					out_of_memory = true;
+				}
+			}
+			if (out_of_memory) {
+				for (ScreenFactory* screen : restored) delete screen;
+				throw std::bad_alloc();
+			}
+
+			gate.pause();
+
+			uint64_t base = std::max<uint64_t>(cpu_cycles, h.cycle);
+			uint64_t shift = base - h.cycle;
 			{
-				std::lock_guard<std::mutex> lock(screens_mutex);
-				screens[name] = screen;
+				std::lock_guard<std::mutex> lock(clock_mutex);
+				cpu_cycles = base;
 			}
+
 			{
-				std::lock_guard<std::mutex> lock(ready_queue_mutex);
-				ready_queue.push(screen);
+				std::lock_guard<ProfiledMutex> lock(waiting_mutex);
+				waiting.reset(base + 1);
+				for (uint32_t i = 0; i < h.processes; i++) {
+					ScreenFactory* screen = restored[i];
+					screens.insert(screen);
+					if (screen->getStatus() == WAITING) {
+						waiting.schedule(&screen->timer, ck.process(i).wake_at + shift);
+					}
+				}
 			}
+
+			// Anything not placed below was mid-admission or mid-preemption when the checkpoint was taken
+			uint64_t q = 0;
+			for (int i = 0; i < cores && i < h.cores; i++) {
+				CheckpointCore c = ck.core(i);
+				ScreenFactory* running_now = screens.get(c.running);
+				if (running_now && running_now->getStatus() == RUNNING) {
+					std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+					running_queue[i] = running_now;
+					slice_used[i].used = c.slice_used;
+					placed[c.running] = 1;
+				}
+
+				CoreQueue& cq = *core_queues[i];
+				std::lock_guard<ProfiledMutex> lock(cq.mx);
+				for (uint32_t k = 0; k < c.queued; k++, q++) {
+					CheckpointQueued entry = ck.queued(q);
+					ScreenFactory* screen = screens.get(entry.pid);    // CheckpointFile checked the pid exists
+					if (screen->getStatus() != READY || placed[entry.pid]) continue;
+					Ready r = { screen, entry.since + shift };
+					cq.q.push_back(r);
+					cq.depth++;
+					placed[entry.pid] = 1;
+				}
+			}
+
+			for (ScreenFactory* screen : restored) {
+				if (placed[screen->getPid()]) continue;
+				if (screen->getStatus() == RUNNING || screen->getStatus() == READY) {
+					screen->setStatus(READY);
+					makeReady(screen);
+				}
+			}
+
+			int expected = next_pid.load();
+			while (expected < h.next_pid && !next_pid.compare_exchange_weak(expected, h.next_pid)) {}
+			migrations += h.migrations;
+			seed = h.seed;      // processes admitted from here on continue the checkpointed workload
+
+			gate.resume();
+			clock_cv.notify_all();
+			return restored.size();
+		}
+
+		bool startTrace(const string& path) {
+			TraceHeader header = {};
+			header.magic = TRACE_MAGIC;
+			header.version = TRACE_VERSION;
+			header.cores = (uint16_t)cores;
+			header.seed = seed;
+			header.quantum = paramTimeslice(sched_params);
+			header.delay = paramDelay(sched_params);
+			header.scheduler = (uint8_t)RR;
+			return trace.open(path, header, cores + 2);
+		}
+
+	private:
+		void admit(ScreenFactory* screen) {
+			screens.insert(screen);
+			trace.recordShared(EV_ARRIVAL, cpu_cycles, screen->getPid(), -1, screen->getTotalLineofInstruction());
+			makeReady(screen);
 			//cout << "Screen '" << name << "' created." << endl;
 		}
 
+	public:
+
 		void displayScreen(string name) {	
-			ScreenFactory* screen = screens[name];
+			ScreenFactory* screen = screens.find(name);
 			system("CLS");
 			cout << "Process name: " << screen->getName() << "\n";
 			cout << "Date created: " << screen->getTime() << "\n";
@@ -88,55 +444,60 @@ class ScreenManager {
 		}
 
 		bool sFind(string name) {
-			auto it = screens.find(name);
-			if (it != screens.end()) {
-				return true;
-			}
-			else {
-				return false; 
-			}
+			return screens.find(name) != nullptr;
 		}
 
 		void isInsideScreen(bool screen) {
 			this->insideScreen = screen;
 		}
 
-		void listScreens() {
+		// A core is busy only while it holds a RUNNING process; cores whose
+		// work is all sleeping or waiting on I/O count as idle.
+		int countBusyCores() {
 			int cpu_usage_count = 0;
 			for (int i = 0; i < cores; i++) {
-				if (screens.find(running_queue[i]) == screens.end()) {
+				ScreenFactory* s = running_queue[i];
+				if (s == nullptr || s->getStatus() != RUNNING) {
 					continue;
 				}
 
 				cpu_usage_count++;
 			}
+			return cpu_usage_count;
+		}
+
+		size_t countWaiting() {
+			std::lock_guard<ProfiledMutex> lock(waiting_mutex);
+			return waiting.size();
+		}
+
+		void listScreens() {
+			int cpu_usage_count = countBusyCores();
 
 			cout << "CPU: " << cpu_usage_count * 100 / cores  <<"%"<< endl;
 			cout << "Cores used: " << cpu_usage_count << '\n';
 			cout << "Cores available: " << cores - cpu_usage_count << '\n';
+			cout << "Processes waiting: " << countWaiting() << '\n';
+			cout << "Migrations: " << migrations << '\n';
 
 			cout << "--------------------------------------\n";
 			cout << "Running processes: \n";
 
 			for (int i = 0; i < cores; i++) {
-				if (screens.find(running_queue[i]) == screens.end()) {
-					continue;
-				}
-
-				ScreenFactory* s = screens[running_queue[i]];
+				ScreenFactory* s = running_queue[i];
+				if (s == nullptr || s->getStatus() != RUNNING) continue;
 				
 				cout << s->getName() << "\t" << s->getTime() << "\tCore:"<<i<<"\t" << s->getLineOfInstruction() << " / " << s->getTotalLineofInstruction() << "\n";
 
 			}
 
 			cout << "\nFinished processes: \n";
-			for (auto& s : screens) {
-				if (s.second->getStatus() == TERMINATED) {
-					cout << s.second->getName() << "\t" << s.second->getTime() << "\tFinished\t" << s.second->getLineOfInstruction() << " / " << s.second->getTotalLineofInstruction() << "\n";
+			screens.forEach([&](ScreenFactory* s) {
+				if (s->getStatus() == TERMINATED) {
+					cout << s->getName() << "\t" << s->getTime() << "\tFinished\t" << s->getLineOfInstruction() << " / " << s->getTotalLineofInstruction() << "\n";
 					count++;
 				}
-				
-			}
+			});
 			/*cout << count << "??????";
 			count = 0;*/
 			cout << "--------------------------------------\n";
@@ -146,40 +507,30 @@ class ScreenManager {
 		void report_util() {
 			ofstream file = ofstream("report.txt");
 
-			int cpu_usage_count = 0;
-			for (int i = 0; i < cores; i++) {
-				if (screens.find(running_queue[i]) == screens.end()) {
-					continue;
-				}
-
-				cpu_usage_count++;
-			}
+			int cpu_usage_count = countBusyCores();
 
 			file << "CPU: " << cpu_usage_count * 100 / cores << "%" << endl;
+			file << "Processes waiting: " << countWaiting() << "\n";
+			file << "Migrations: " << migrations << "\n";
 
 			file << "--------------------------------------\n";
 			file << "Running processes: \n";
 
 			for (int i = 0; i < cores; i++) {
-				if (screens.find(running_queue[i]) == screens.end()) {
-					continue;
-				}
-
-				ScreenFactory* s = screens[running_queue[i]];
-				if (s->getStatus() == RUNNING) {
+				ScreenFactory* s = running_queue[i];
+				if (s != nullptr && s->getStatus() == RUNNING) {
 					file << s->getName() << "\t" << s->getTime() << "\tCore:" << i << "\t" << s->getLineOfInstruction() << " / " << s->getTotalLineofInstruction() << "\n";
 
 				}
 			}
 
 			file << "\nFinished processes: \n";
-			for (auto& s : screens) {
-				if (s.second->getStatus() == TERMINATED) {
-					file << s.second->getName() << "\t" << s.second->getTime() << "\tFinished\t" << s.second->getLineOfInstruction() << " / " << s.second->getTotalLineofInstruction() << "\n";
+			screens.forEach([&](ScreenFactory* s) {
+				if (s->getStatus() == TERMINATED) {
+					file << s->getName() << "\t" << s->getTime() << "\tFinished\t" << s->getLineOfInstruction() << " / " << s->getTotalLineofInstruction() << "\n";
 					count++;
 				}
-
-			}
+			});
 			/*cout << count << "??????";
 			count = 0;*/
 			file << "--------------------------------------\n";
@@ -190,133 +541,405 @@ class ScreenManager {
 		}
 
 		void coreJob(int i) {
-			int delay = this->delay;
 			while (running) {
-				std::string screen_name;
 				{
-					std::lock_guard<std::mutex> lock(running_queue_mutex);
-					screen_name = running_queue[i];
-				}
+					PauseGate::Hold hold(gate, i);
+					ScreenFactory* screen = current(i);
+					if (screen == nullptr) {
+						// Pick up the next process as soon as the last one leaves
+						screen = dispatch(i);
+					}
 
-				if (screens.find(screen_name) != screens.end()) {
-					// Process exists in screens and hasn't been terminated
-					screens[screen_name]->print(i);
+					if (screen != nullptr) {
+						step(i, screen);
+					}
 				}
 
-				Sleep(delay*1000+1); // Adjust this as needed
+				coreWait(i, (uint64_t)paramDelay(sched_params) * 1000 + 1);
 			}
 		}
 
 		void coreJob_RR(int i) {
-			int time_slice = this->timeslice;
-			int counter = 0;
-			int delay = this->delay;
-			
 			while (running) {
-				std::string screen_name;
+				uint64_t ticks;
 				{
-					std::lock_guard<std::mutex> lock(running_queue_mutex);
-					screen_name = running_queue[i]; 
+					PauseGate::Hold hold(gate, i);
+					ticks = sliceStep(i);
 				}
+				coreWait(i, ticks);
+			}
+		}
 
-				{
-					// Key is not present
-					std::lock_guard<std::mutex> lock(screens_mutex);
-					if (screens.find(screen_name) == screens.end()) continue;
+		// One pass of an rr core; returns how many ticks to wait before the next
+		uint64_t sliceStep(int i) {
+			uint64_t params = sched_params;
+			uint32_t time_slice = paramTimeslice(params);
+			uint32_t delay = paramDelay(params);
+
+			ScreenFactory* screen = current(i);
+			if (screen == nullptr) {
+				screen = dispatch(i);
+			}
 
-					// Process is done
-					/*std::lock_guard<std::mutex> lock(screens_mutex);*/
-					if (screens[screen_name]->getStatus() == TERMINATED) {
+			// Core is idle
+			if (screen == nullptr) {
+				return 1;
+			}
+
+			// Current process has reached allotted time slice
+			if (slice_used[i].used >= time_slice) {
+				slice_used[i].used = 0;
 
-						counter = 0;
-						continue;
+				// Only give up the core if something is waiting for it
+				if (queueDepth(i) > 0) {
+					{	// Vacate the core so the process can't end up on two cores
+						std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+						running_queue[i] = nullptr;
 					}
+
+					// Change status to ready 
+					screen->setStatus(READY);
+
+					trace.record(i, EV_PREEMPT, cpu_cycles, screen->getPid(), i);
+
+					// Requeue on this core, where its working set still is
+					makeReady(screen);
+					return 0;
 				}
+			} // ENDIF
 
-				// Current process has reached allotted time slice
-				if (counter >= time_slice) {
+			if (!step(i, screen)) {
+				// Blocked or finished, either way the slice ends here
+				slice_used[i].used = 0;
+			}
+			else {
+				slice_used[i].used++;
+			}
 
-					if (ready_queue.empty()) {
-						counter = 0;
-						continue;
-					}
+			return (uint64_t)delay * 1000 + 1;
+		}
 
-					if (screens[screen_name]->getStatus() != TERMINATED) {
-						{	// Change status to ready 
-							std::lock_guard<std::mutex> lock(screens_mutex);
-							screens[screen_name]->setStatus(READY);
-						}
+		ScreenFactory* current(int i) {
+			std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+			return running_queue[i];
+		}
 
-						{	// Requeue process
-							std::lock_guard<std::mutex> lock(ready_queue_mutex);
-							ready_queue.push(screens[screen_name]);
-						}
-					}
+		// Run one instruction of <screen> on core <i>; false once it leaves the core
+		bool step(int i, ScreenFactory* screen) {
+			if (screen->getStatus() != RUNNING) return false;
 
-					counter = 0;
-					continue;
-				} // ENDIF
+			int ticks = screen->execute(i);
+			if (ticks > 0) {
+				blockProcess(i, screen, ticks);
+				return false;
+			}
+			if (screen->getStatus() == TERMINATED) {
+				trace.record(i, EV_TERMINATE, cpu_cycles, screen->getPid(), i);
+				std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+				running_queue[i] = nullptr;
+				return false;
+			}
+			return true;
+		}
+
+		// Park a process in the timer wheel and free its core right away
+		void blockProcess(int core, ScreenFactory* screen, int ticks) {
+			{
+				// Vacate the core first so it never holds a process that is already waiting
+				std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+				running_queue[core] = nullptr;
+			}
+
+			trace.record(core, EV_BLOCK, cpu_cycles, screen->getPid(), core, ticks);
+
+			std::lock_guard<ProfiledMutex> lock(waiting_mutex);
+			screen->setStatus(WAITING);
+			waiting.schedule(&screen->timer, cpu_cycles + ticks);
+		}
+
+		// Block the calling thread until the clock has advanced <ticks>
+		void waitCycles(uint64_t ticks) {
+			waitUntilCycle(cpu_cycles + ticks);
+		}
+
+		void waitUntilCycle(uint64_t target) {
+			std::unique_lock<std::mutex> lock(clock_mutex);
+			clock_cv.wait(lock, [&] { return cpu_cycles >= target || !running; });
+		}
+
+		// waitCycles for core <i>, which also tells a lockstep clock the core is done with this tick
+		void coreWait(int i, uint64_t ticks) {
+			std::unique_lock<std::mutex> lock(clock_mutex);
+			uint64_t target = cpu_cycles + ticks;
+			if (ticks == 0) return;
+
+			core_target[i] = target;
+			if (lockstep) tick_cv.notify_one();
+			clock_cv.wait(lock, [&] { return cpu_cycles >= target || !running; });
+			core_target[i] = 0;
+		}
 
-				if (screens[screen_name]->getStatus() == RUNNING) {
-					screens[screen_name]->print(i);
+		// Lockstep only: true once no core has anything left to do this tick
+		bool coresDone() {
+			for (int i = 0; i < cores; i++) {
+				if (core_target[i] <= cpu_cycles) return false;
+			}
+			return true;
+		}
+
+		// Advances the simulation clock and moves expired sleepers back to ready
+		void clockJob() {
+			std::vector<TimerNode*> woken;
+			while (running) {
+				if (lockstep) {
+					std::unique_lock<std::mutex> lock(clock_mutex);
+					tick_cv.wait(lock, [&] { return !running || !lockstep || coresDone(); });
 				}
-				
-				counter++;
+				else {
+					Sleep(1);
+				}
+				PauseGate::Hold hold(gate, clockRing());
 
-				
-				Sleep(delay * 1000 + 1);
+				uint64_t now;
+				{
+					std::lock_guard<std::mutex> lock(clock_mutex);
+					now = ++cpu_cycles;
+				}
+
+				{
+					std::lock_guard<ProfiledMutex> lock(waiting_mutex);
+					waiting.advance(now, woken);
+				}
+
+				for (TimerNode* t : woken) {
+					ScreenFactory* s = static_cast<ScreenFactory*>(t->owner);
+					s->setStatus(READY);
+					trace.record(clockRing(), EV_WAKE, now, s->getPid(), -1);
+					makeReady(s);
+				}
+				woken.clear();
+
+				clock_cv.notify_all();
+			}
+			clock_cv.notify_all();
+		}
+
+		/*--- Affinity-aware ready queues ---*/
+
+		int queueDepth(int i) {
+			return core_queues[i]->depth;
+		}
+
+		// Queued plus running work on core <i>
+		int coreLoad(int i) {
+			return queueDepth(i) + (current(i) != nullptr ? 1 : 0);
+		}
+
+		int leastLoadedCore() {
+			int best = 0;
+			int best_load = coreLoad(0);
+			for (int i = 1; i < cores && best_load > 0; i++) {
+				int load = coreLoad(i);
+				if (load < best_load) {
+					best = i;
+					best_load = load;
+				}
 			}
+			return best;
 		}
 
-		std::string findFirst() {
-			std::string next_up = "";
-			std::lock_guard<std::mutex> lock(ready_queue_mutex);
+		// Queue a READY process on the core it last ran on, or the least loaded one if it never ran
+		void makeReady(ScreenFactory* screen) {
+			int target = screen->getLastCore();
+			if (target < 0) target = leastLoadedCore();
 
-			if (!ready_queue.empty()) {
-				ScreenFactory* process = ready_queue.front();
-				ready_queue.pop();
-				next_up = process->getName();
+			CoreQueue& cq = *core_queues[target];
+			std::lock_guard<ProfiledMutex> lock(cq.mx);
+			Ready r = { screen, cpu_cycles };
+			cq.q.push_back(r);
+			cq.depth++;
+		}
+
+		// Take the next process off core <i>'s own queue and run it
+		ScreenFactory* dispatch(int i) {
+			ScreenFactory* next_up = nullptr;
+			{
+				CoreQueue& cq = *core_queues[i];
+				std::lock_guard<ProfiledMutex> lock(cq.mx);
+				if (cq.q.empty()) return nullptr;
+				Ready r = cq.q.front();
+				cq.q.pop_front();
+				cq.depth--;
+				next_up = r.screen;
+
+				uint64_t wait = cpu_cycles - r.since;
+				cq.dispatches++;
+				cq.wait_total += wait;
+				if (wait > cq.wait_max) cq.wait_max = wait;
 			}
+
+			next_up->setStatus(RUNNING);
+			next_up->setLastCore(i);
+			slice_used[i].used = 0;
+			{
+				std::lock_guard<ProfiledMutex> lock(running_queue_mutex);
+				running_queue[i] = next_up;
+			}
+			trace.record(i, EV_DISPATCH, cpu_cycles, next_up->getPid(), i);
 			return next_up;
 		}
 
+		// Move queued (never running) processes from the busiest to the idlest
+		// core, but only while their loads differ by at least IMBALANCE_THRESHOLD
+		void balance() {
+			for (int round = 0; round < cores; round++) {
+				int busiest = 0, idlest = 0;
+				int max_load = coreLoad(0), min_load = max_load;
+				for (int i = 1; i < cores; i++) {
+					int load = coreLoad(i);
+					if (load > max_load) { busiest = i; max_load = load; }
+					if (load < min_load) { idlest = i; min_load = load; }
+				}
+				if (max_load - min_load < IMBALANCE_THRESHOLD) return;
+
+				CoreQueue& from = *core_queues[busiest];
+				CoreQueue& to = *core_queues[idlest];
+				std::unique_lock<ProfiledMutex> lock_from(from.mx, std::defer_lock);
+				std::unique_lock<ProfiledMutex> lock_to(to.mx, std::defer_lock);
+				std::lock(lock_from, lock_to);
+
+				// First move processes that never ran on the busy core. One that did only
+				// moves after waiting BALANCE_INTERVAL ticks, when little of its state is left there.
+				int moves = (max_load - min_load) / 2;
+				int moved = 0;
+				for (int pass = 0; pass < 2 && moved < moves; pass++) {
+					for (size_t k = from.q.size(); k-- > 0 && moved < moves;) {
+						Ready r = from.q[k];
+						ScreenFactory* s = r.screen;
+						bool ran_here = s->getLastCore() == busiest;
+						if (pass == 0 ? ran_here : cpu_cycles - r.since < BALANCE_INTERVAL) continue;
+
+						from.q.erase(from.q.begin() + k);
+						from.depth--;
+						to.q.push_back(r);
+						to.depth++;
+						moved++;
+						migrations++;
+						trace.record(managerRing(), EV_MIGRATE, cpu_cycles, s->getPid(), busiest, idlest);
+					}
+				}
+				if (moved == 0) return;
+			}
+		}
+
 		void managerJob() {
 			while (running) {
-				
-				for (int i = 0; i < cores; i++) {
-					std::string next_up;
-					{
-						// Lock the mutexes for screens and running_queue
-						std::unique_lock<std::mutex> lock_screens(screens_mutex, std::defer_lock);
-						std::unique_lock<std::mutex> lock_running(running_queue_mutex, std::defer_lock);
-						std::lock(lock_screens, lock_running); // Lock both mutexes
-						if (screens.find(running_queue[i]) == screens.end() || screens[running_queue[i]]->getStatus() != RUNNING) {
-							//screen doesnt exist yet or is not running 
-
-							{
-								// find if smthn is ready
-								next_up = findFirst();
-							}
-							if (next_up == "") {
-								running_queue[i] = "";
-								continue;
-							};
-
-							screens[next_up]->setStatus(RUNNING);
-							running_queue[i] = next_up;
-							continue;
-						} // ENDIF
-					} //END MUTEX LOCK
-				}// ENDFORLOOP
-
-				//listScreens();
-
-			/*	std::cout << "RQ: " << ready_queue.size(); */
+				waitCycles(BALANCE_INTERVAL);
+				PauseGate::Hold hold(gate, managerRing());
+				balance();
+			}
+		}
+
+		/*--- process-smi ---*/
+
+		static const size_t SMI_PAGE_LINES = 50;     // log lines per buffered write
+		static const size_t SMI_FOLLOW_LINES = 10;   // history shown before --follow streams
+		static const int SMI_FOLLOW_POLL_MS = 100;
+
+		// Print log lines [from, to) one screenful per write; returns where it stopped
+		size_t printLogs(ScreenFactory* screen, size_t from, size_t to) {
+			string page;
+			while (from < to) {
+				page.clear();
+				size_t next = screen->appendLogs(from, std::min<size_t>(to, from + SMI_PAGE_LINES), page);
+				if (next == from) break;
+				cout.write(page.data(), page.size());
+				cout.flush();
+				from = next;
+			}
+			return from;
+		}
+
+		// Stream new log lines from <cursor> until the process finishes or a key is pressed
+		void followLogs(ScreenFactory* screen, size_t cursor) {
+			cout << "(following, press any key to stop)\n";
+			while (!_kbhit()) {
+				cursor = printLogs(screen, cursor, SIZE_MAX);
+				if (screen->getStatus() == TERMINATED && cursor >= screen->getLogCount()) {
+					return;
+				}
+				Sleep(SMI_FOLLOW_POLL_MS);
+			}
+			_getch();
+		}
+
+		static bool parseLine(const string& text, size_t& out) {
+			if (text.empty() || text.find_first_not_of("0123456789") != string::npos) return false;
+			try {
+				out = std::stoull(text);
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+			return true;
+		}
+
+		// process-smi [--tail N | --range a:b] [--follow]; lines are numbered from 1
+		void processSmi(string name, ScreenFactory* screen, const vector<string>& args) {
+			size_t count = screen->getLogCount();
+			size_t from = 0, to = SIZE_MAX;
+			bool follow = false, windowed = false;
+
+			for (size_t i = 1; i < args.size(); i++) {
+				size_t n;
+				if (args[i] == "--follow") {
+					follow = true;
+				}
+				else if (args[i] == "--tail" && i + 1 < args.size() && !windowed && parseLine(args[i + 1], n)) {
+					from = count > n ? count - n : 0;
+					windowed = true;
+					i++;
+				}
+				else if (args[i] == "--range" && i + 1 < args.size() && !windowed) {
+					const string& r = args[++i];
+					size_t colon = r.find(':');
+					size_t a = 1, b = SIZE_MAX;
+					if (colon == string::npos
+						|| (colon > 0 && !parseLine(r.substr(0, colon), a))
+						|| (colon + 1 < r.size() && !parseLine(r.substr(colon + 1), b))
+						|| a == 0 || b < a) {
+						cout << "Invalid range: " << r << " (expected a:b with 1 <= a <= b)\n";
+						return;
+					}
+					from = a - 1;
+					to = b;
+					windowed = true;
+				}
+				else {
+					cout << "Usage: process-smi [--tail N | --range a:b] [--follow]\n";
+					return;
+				}
+			}
+			if (follow && !windowed) {
+				from = count > SMI_FOLLOW_LINES ? count - SMI_FOLLOW_LINES : 0;
+			}
+
+			displayScreen(name);                  /* header/info  */
+			cout << "Logs:\n";
+			if (follow) {
+				// a range only sets where streaming starts
+				followLogs(screen, from);
+			}
+			else {
+				printLogs(screen, from, std::min<size_t>(to, count));
+			}
+			if (screen->getStatus() == TERMINATED) {
+				cout << "Finished!\n";
 			}
 		}
 
 		void loopScreen(string name) {
-			ScreenFactory* screen = screens[name];
+			ScreenFactory* screen = screens.find(name);
 			vector<string> inputBuffer;
 			string input;
 
@@ -338,15 +961,7 @@ class ScreenManager {
 					return;
 				}
 				else if (firstInput == "process-smi") {   /* NEW */
-					displayScreen(name);                  /* header/info  */
-					auto logs = screen->getLogsCopy();
-					cout << "Logs:\n";
-					for (const auto& ln : logs) {
-						cout << ln << '\n';
-					}
-					if (screen->getStatus() == TERMINATED) {
-						cout << "Finished!\n";
-					}
+					processSmi(name, screen, inputBuffer);
 				}
 				else {
 					/* fall-back: simple echo */
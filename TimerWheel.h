@@ -0,0 +1,150 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Intrusive timer node. Every ScreenFactory embeds one, so arming a
+ * timer never allocates and cancelling it is a plain unlink.
+ */
+struct TimerNode {
+    uint64_t   expires = 0;
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    void*      owner = nullptr;
+
+    bool armed() const { return next != nullptr; }
+};
+
+/*
+ * Hierarchical timer wheel keyed on the simulation clock.
+ *
+ * Four levels of 64 slots cover 2^24 ticks; anything further out sits on
+ * an overflow list that is re-sorted whenever the top level wraps. A timer
+ * is cascaded at most once per level on its way down, so arming, cancelling
+ * and expiring are all O(1) per timer regardless of how many are pending.
+ */
+class TimerWheel {
+private:
+    static const int LEVEL_BITS = 6;
+    static const int LEVEL_SIZE = 1 << LEVEL_BITS;
+    static const int LEVEL_MASK = LEVEL_SIZE - 1;
+    static const int LEVELS = 4;
+
+    TimerNode slots[LEVELS][LEVEL_SIZE];   // sentinel heads of circular lists
+    TimerNode overflow;
+    uint64_t  current = 0;                 // next tick to be processed
+    size_t    pending = 0;
+
+    static void initHead(TimerNode& head) {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    static void link(TimerNode& head, TimerNode* node) {
+        node->prev = head.prev;
+        node->next = &head;
+        head.prev->next = node;
+        head.prev = node;
+    }
+
+    static void unlink(TimerNode* node) {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+    }
+
+    void place(TimerNode* node) {
+        if (node->expires < current) node->expires = current;
+        uint64_t delta = node->expires - current;
+
+        for (int level = 0; level < LEVELS; level++) {
+            if (delta < (1ull << (LEVEL_BITS * (level + 1)))) {
+                int idx = (int)((node->expires >> (LEVEL_BITS * level)) & LEVEL_MASK);
+                link(slots[level][idx], node);
+                return;
+            }
+        }
+        link(overflow, node);
+    }
+
+    /* re-place every timer of one slot; they all land on lower levels */
+    void cascade(TimerNode& head) {
+        TimerNode list;
+        initHead(list);
+        if (head.next != &head) {
+            list.next = head.next;
+            list.prev = head.prev;
+            list.next->prev = &list;
+            list.prev->next = &list;
+            initHead(head);
+        }
+        while (list.next != &list) {
+            TimerNode* node = list.next;
+            unlink(node);
+            place(node);
+        }
+    }
+
+public:
+    TimerWheel() {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int i = 0; i < LEVEL_SIZE; i++) {
+                initHead(slots[level][i]);
+            }
+        }
+        initHead(overflow);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    size_t size() const { return pending; }
+    uint64_t now() const { return current; }
+
+    /* move an empty wheel to <tick>, e.g. after the clock was restored */
+    void reset(uint64_t tick) {
+        if (pending == 0) current = tick;
+    }
+
+    /* arm <node> to fire at absolute tick <expires> */
+    void schedule(TimerNode* node, uint64_t expires) {
+        if (node->armed()) cancel(node);
+        node->expires = expires;
+        place(node);
+        pending++;
+    }
+
+    void cancel(TimerNode* node) {
+        if (!node->armed()) return;
+        unlink(node);
+        pending--;
+    }
+
+    /* process every tick up to and including <target>, collecting expired timers */
+    void advance(uint64_t target, std::vector<TimerNode*>& expired) {
+        while (current <= target) {
+            int idx = (int)(current & LEVEL_MASK);
+
+            if (idx == 0) {
+                int level = 1;
+                for (; level < LEVELS; level++) {
+                    int upper = (int)((current >> (LEVEL_BITS * level)) & LEVEL_MASK);
+                    cascade(slots[level][upper]);
+                    if (upper != 0) break;
+                }
+                if (level == LEVELS) cascade(overflow);
+            }
+
+            TimerNode& head = slots[0][idx];
+            while (head.next != &head) {
+                TimerNode* node = head.next;
+                unlink(node);
+                pending--;
+                expired.push_back(node);
+            }
+            current++;
+        }
+    }
+};
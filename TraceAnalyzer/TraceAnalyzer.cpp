@@ -0,0 +1,258 @@
+#include "../EventTrace.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+
+/*
+ * Offline analyzer for the binary traces written through "trace-file".
+ *
+ *   TraceAnalyzer <trace> [--stats] [--gantt [width]] [--chrome <out.json>]
+ *
+ * With no option it prints the summary stats.
+ */
+
+struct Slice {
+    uint32_t pid;
+    int      core;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct Timeline {
+    TraceHeader header;
+    std::vector<TraceEvent> events;
+    std::vector<Slice> slices;              // time each process spent on a core
+    std::vector<uint64_t> queue_latency;    // ready -> dispatch, in ticks
+    std::vector<uint64_t> turnaround;       // arrival -> terminate, in ticks
+    uint64_t first = 0;
+    uint64_t last = 0;
+    size_t dispatches = 0;
+    size_t preemptions = 0;
+    size_t blocks = 0;
+    size_t migrations = 0;
+};
+
+void buildTimeline(Timeline& t) {
+    std::map<uint32_t, Slice> open;         // pid -> slice still on a core
+    std::map<uint32_t, uint64_t> ready_at;  // pid -> cycle it became ready
+    std::map<uint32_t, uint64_t> arrived_at;
+
+    if (!t.events.empty()) {
+        t.first = t.events.front().cycle;
+        t.last = t.events.back().cycle;
+    }
+
+    auto closeSlice = [&](uint32_t pid, uint64_t cycle) {
+        auto it = open.find(pid);
+        if (it == open.end()) return;
+        it->second.end = cycle;
+        t.slices.push_back(it->second);
+        open.erase(it);
+    };
+
+    for (const TraceEvent& ev : t.events) {
+        switch (ev.type) {
+        case EV_ARRIVAL:
+            arrived_at[ev.pid] = ev.cycle;
+            ready_at[ev.pid] = ev.cycle;
+            break;
+        case EV_WAKE:
+            ready_at[ev.pid] = ev.cycle;
+            break;
+        case EV_PREEMPT:
+            closeSlice(ev.pid, ev.cycle);
+            ready_at[ev.pid] = ev.cycle;
+            t.preemptions++;
+            break;
+        case EV_BLOCK:
+            closeSlice(ev.pid, ev.cycle);
+            t.blocks++;
+            break;
+        case EV_TERMINATE:
+            closeSlice(ev.pid, ev.cycle);
+            if (arrived_at.count(ev.pid)) {
+                t.turnaround.push_back(ev.cycle - arrived_at[ev.pid]);
+            }
+            break;
+        case EV_MIGRATE:
+            t.migrations++;
+            break;
+        case EV_DISPATCH: {
+            closeSlice(ev.pid, ev.cycle);
+            auto it = ready_at.find(ev.pid);
+            if (it != ready_at.end()) {
+                t.queue_latency.push_back(ev.cycle - it->second);
+                ready_at.erase(it);
+            }
+            Slice s = { ev.pid, ev.core, ev.cycle, ev.cycle };
+            open[ev.pid] = s;
+            t.dispatches++;
+            break;
+        }
+        }
+    }
+
+    for (auto& o : open) {
+        o.second.end = t.last;
+        t.slices.push_back(o.second);
+    }
+}
+
+uint64_t percentile(std::vector<uint64_t>& v, double p) {
+    if (v.empty()) return 0;
+    size_t idx = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+    return v[idx];
+}
+
+void printStats(Timeline& t) {
+    int cores = t.header.cores;
+    uint64_t span = t.last - t.first + 1;
+
+    std::vector<uint64_t> busy(cores, 0);
+    for (const Slice& s : t.slices) {
+        if (s.core >= 0 && s.core < cores) busy[s.core] += s.end - s.start;
+    }
+    uint64_t total_busy = 0;
+    for (uint64_t b : busy) total_busy += b;
+
+    std::sort(t.queue_latency.begin(), t.queue_latency.end());
+    std::sort(t.turnaround.begin(), t.turnaround.end());
+
+    std::cout << "Trace: " << t.events.size() << " events, " << span << " cycles, seed " << t.header.seed
+        << ", " << cores << " cores, " << (t.header.scheduler ? "rr" : "fcfs")
+        << " (quantum " << t.header.quantum << ", delay " << t.header.delay << ")\n";
+    if (t.header.dropped > 0) {
+        std::cout << "WARNING: " << t.header.dropped << " events were dropped while recording\n";
+    }
+
+    std::cout << "--------------------------------------\n";
+    std::cout << "CPU utilization: " << (span ? total_busy * 100 / (span * cores) : 0) << "%\n";
+    for (int c = 0; c < cores; c++) {
+        std::cout << "  Core:" << c << "\t" << (span ? busy[c] * 100 / span : 0) << "%\n";
+    }
+
+    std::cout << "Dispatches: " << t.dispatches
+        << " (" << (double)t.dispatches * 1000.0 / span << " per 1000 cycles)\n";
+    std::cout << "Preemptions: " << t.preemptions << "\n";
+    std::cout << "Blocks (SLEEP/IO_WAIT): " << t.blocks << "\n";
+    std::cout << "Migrations: " << t.migrations << "\n";
+
+    std::cout << "Queue latency (cycles): p50 " << percentile(t.queue_latency, 50)
+        << "  p90 " << percentile(t.queue_latency, 90)
+        << "  p99 " << percentile(t.queue_latency, 99)
+        << "  max " << (t.queue_latency.empty() ? 0 : t.queue_latency.back()) << "\n";
+    std::cout << "Turnaround (cycles):    p50 " << percentile(t.turnaround, 50)
+        << "  p90 " << percentile(t.turnaround, 90)
+        << "  p99 " << percentile(t.turnaround, 99)
+        << "  (" << t.turnaround.size() << " finished)\n";
+    std::cout << "--------------------------------------\n";
+}
+
+/* one row per core; each column shows the process that held the core longest in that window */
+void printGantt(const Timeline& t, int width) {
+    static const char symbols[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    int cores = t.header.cores;
+    uint64_t span = t.last - t.first + 1;
+    double per_col = (double)span / width;
+
+    std::vector<std::vector<uint64_t>> owned(cores, std::vector<uint64_t>(width, 0));
+    std::vector<std::string> rows(cores, std::string(width, '.'));
+
+    for (const Slice& s : t.slices) {
+        if (s.core < 0 || s.core >= cores || s.end <= s.start) continue;
+        int from = (int)((s.start - t.first) / per_col);
+        int to = std::min(width - 1, (int)((s.end - 1 - t.first) / per_col));
+        for (int col = from; col <= to; col++) {
+            uint64_t lo = t.first + (uint64_t)(col * per_col);
+            uint64_t hi = t.first + (uint64_t)((col + 1) * per_col);
+            uint64_t overlap = std::min(hi, s.end) - std::max(lo, s.start);
+            if (std::min(hi, s.end) > std::max(lo, s.start) && overlap >= owned[s.core][col]) {
+                owned[s.core][col] = overlap;
+                rows[s.core][col] = symbols[s.pid % (sizeof(symbols) - 1)];
+            }
+        }
+    }
+
+    std::cout << "Cycles " << t.first << " - " << t.last << ", " << per_col << " cycles per column"
+        << " (symbol = pid mod 62, '.' = idle)\n";
+    for (int c = 0; c < cores; c++) {
+        std::cout << "Core:" << c << (c < 10 ? "  |" : " |") << rows[c] << "|\n";
+    }
+}
+
+/* Chrome trace-event format, viewable in chrome://tracing or Perfetto; one tick = 1 ms */
+bool writeChrome(const Timeline& t, const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto sep = [&]() { if (!first) out << ",\n"; first = false; };
+
+    for (int c = 0; c < t.header.cores; c++) {
+        sep();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << c
+            << ",\"args\":{\"name\":\"Core " << c << "\"}}";
+    }
+    for (const Slice& s : t.slices) {
+        sep();
+        out << "{\"name\":\"Process_" << s.pid << "\",\"cat\":\"run\",\"ph\":\"X\",\"pid\":0,\"tid\":" << s.core
+            << ",\"ts\":" << s.start * 1000 << ",\"dur\":" << (s.end - s.start) * 1000 << "}";
+    }
+    for (const TraceEvent& ev : t.events) {
+        if (ev.type != EV_ARRIVAL && ev.type != EV_BLOCK) continue;
+        sep();
+        out << "{\"name\":\"" << (ev.type == EV_ARRIVAL ? "arrival" : "block") << " Process_" << ev.pid
+            << "\",\"cat\":\"event\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << ev.cycle * 1000
+            << ",\"args\":{\"arg\":" << ev.arg << "}}";
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: TraceAnalyzer <trace> [--stats] [--gantt [width]] [--chrome <out.json>]\n";
+        return 1;
+    }
+
+    Timeline t;
+    if (!EventTrace::load(argv[1], t.header, t.events)) {
+        std::cerr << "Could not read trace file: " << argv[1] << "\n";
+        return 1;
+    }
+    buildTimeline(t);
+
+    bool stats = argc == 2;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            stats = true;
+        }
+        else if (arg == "--gantt") {
+            int width = 100;
+            if (i + 1 < argc && argv[i + 1][0] != '-') width = std::max(1, atoi(argv[++i]));
+            printGantt(t, width);
+        }
+        else if (arg == "--chrome" && i + 1 < argc) {
+            std::string path = argv[++i];
+            if (writeChrome(t, path)) {
+                std::cout << "Chrome trace written to " << path << "\n";
+            }
+            else {
+                std::cerr << "Could not write " << path << "\n";
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (stats) printStats(t);
+    return 0;
+}